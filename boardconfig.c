@@ -29,117 +29,632 @@
 
 //TODO: Why does this module needs to know hoe many CRCs there is and where stuff is supposed to be? Should be generic
 
-static bool init_done = false;
-static shadow_memory_t shadow;
-static uint8_t shadow_memory[kBoardConfigTotalSize];
-static uint8_t double_buffer[kBoardConfigTotalSize];
+typedef struct{
+    uint32_t offset;
+    uint32_t size;
+    uint32_t crc_offset;
+}section_t;
 
-static int Write(uint32_t inAddress, const uint8_t* inData, uint32_t inSize);
-static int Commit(void);
+static const section_t sections[] = {
+    {kBoardConfig_FactoryAddressOffset, kBoardConfig_FactorySize, kBoardConfig_Factory_CRC},
+    {kBoardConfig_UserAddressOffset, kBoardConfig_UserSize, kBoardConfig_User_CRC},
+};
+#define kSectionCount (sizeof(sections) / sizeof(sections[0]))
 
-int BoardConfig_Init(board_config_config_t* config){
+// The shadow is loaded from the medium on first access, by chunks tracked in pending_chunks.
+#define kChunkCount 32
+#define kChunkSize ((kBoardConfigTotalSize + kChunkCount - 1) / kChunkCount)
+
+#ifdef kBoardConfig_HeaderAddressOffset
+// Header fields, big endian: magic, layout, reserved, one CRC per section, digest of the previous bytes.
+#define kHeader_Magic 0
+#define kHeader_Layout 2
+#define kHeader_SectionCRC 4
+#define kHeader_Digest (kHeader_SectionCRC + 2 * kSectionCount)
+_Static_assert(kHeader_Digest + 2 == kBoardConfig_HeaderSize, "Header size does not match the sections");
+#endif
+
+typedef enum{
+    kImageStatus_Valid,
+    kImageStatus_Invalid,
+    kImageStatus_OtherLayout,
+}image_status_t;
+
+static uint8_t default_memory[kBoardConfigTotalSize];
+static uint8_t default_double_buffer[kBoardConfigTotalSize];
+static board_config_t default_instance = {
+    .memory = default_memory,
+    .double_buffer = default_double_buffer,
+    .offset_on_medium = kBoardConfigStartAddress,
+};
+
+static int Write(board_config_t* instance, uint32_t inAddress, const uint8_t* inData, uint32_t inSize);
+static int Commit(board_config_t* instance, uint32_t dirty_chunks);
+static uint32_t UpdateChecksums(uint8_t* image);
+static image_status_t ValidateImage(const uint8_t* image);
+static void ForceDefaults(board_config_t* instance);
+static bool Migrate(board_config_t* instance, const board_config_config_t* config);
+static int Load(board_config_t* instance, uint32_t inAddress, uint32_t inSize);
+static int LoadChunks(board_config_t* instance, uint32_t mask);
+static int FlushChunks(board_config_t* instance, uint32_t mask);
+static uint32_t ChunkMask(uint32_t inAddress, uint32_t inSize);
+static void Lock(board_config_t* instance);
+static void Unlock(board_config_t* instance);
+static bool ReserveDoubleBuffer(board_config_t* instance);
+static void ReleaseDoubleBuffer(board_config_t* instance);
+#ifdef kBoardConfig_HeaderAddressOffset
+static bool ReadHeader(board_config_t* instance);
+static void BuildHeader(const uint8_t* image, uint8_t* header);
+#endif
+
+int BoardConfigInstance_Init(board_config_t* instance, board_config_config_t* config){
     int status = -1;
-    if(config && (config->get_defaults)){
-        shadow.shadow_lock = config->shadow_lock;
-        shadow.lock = config->lock;
-        shadow.unlock = config->unlock;
-        shadow.write_to_medium = config->write_to_medium;
-        shadow.read_from_medium = config->read_from_medium;
-        shadow.offset_on_medium = kBoardConfigStartAddress;
-        shadow.memory = shadow_memory;
-        shadow.memory_size = kBoardConfigTotalSize;
-        if(SHADOW_MEMORY_Sync(&shadow) == kBoardConfigTotalSize){
-            if(SHADOW_MEMORY_Read(&shadow, 0, double_buffer, kBoardConfigTotalSize) == kBoardConfigTotalSize){
-                uint16_t factoryCRC = CRC16ComputeCRC(0, (uint8_t*)(double_buffer + kBoardConfig_FactoryAddressOffset), kBoardConfig_FactorySize);
-                uint16_t userCRC = CRC16ComputeCRC(0, (uint8_t*)(double_buffer + kBoardConfig_UserAddressOffset), kBoardConfig_UserSize);
-                bool config_valid = true;
-                if (*(uint16_t*)(double_buffer + kBoardConfig_Factory_Magic) != mHTONS(kBoardConfig_MagicNumber))
-                {
-                    mBoardConfigPrintWarning("Bad magic");
-                    config_valid = false;
-                }
-                else if (double_buffer[kBoardConfig_Factory_FlashLayout] != kVersionConfigLayout)
-                {
-                    mBoardConfigPrintWarning("Bad layout");
-                    config_valid = false;
-                }
-                else if (mHTONS(factoryCRC) != *((uint16_t*)(double_buffer + kBoardConfig_Factory_CRC)))
-                {
-                    mBoardConfigPrintWarning("Bad factory CRC");
-                    config_valid = false;
+    if(instance && instance->memory && instance->double_buffer && config && (config->get_defaults)){
+        instance->init_done = false;
+        instance->in_transaction = false;
+        instance->double_buffer_busy = false;
+        instance->get_defaults = config->get_defaults;
+        instance->pending_chunks = ChunkMask(0, kBoardConfigTotalSize);
+        instance->uncommitted_chunks = 0;
+        instance->shadow.shadow_lock = config->shadow_lock;
+        instance->shadow.lock = config->lock;
+        instance->shadow.unlock = config->unlock;
+        instance->shadow.write_to_medium = config->write_to_medium;
+        instance->shadow.read_from_medium = config->read_from_medium;
+        instance->shadow.offset_on_medium = instance->offset_on_medium;
+        instance->shadow.memory = instance->memory;
+        instance->shadow.memory_size = kBoardConfigTotalSize;
+#ifdef kBoardConfig_HeaderAddressOffset
+        if(ReadHeader(instance)){
+            // Body is loaded on first access and checked by BoardConfigInstance_Verify.
+            mBoardConfigPrintInfo("Loaded header");
+            status = 0;
+            instance->init_done = true;
+        }
+        else
+#endif
+        if(Load(instance, 0, kBoardConfigTotalSize) == 0){
+            uint8_t* double_buffer = instance->double_buffer;
+            if(SHADOW_MEMORY_Read(&instance->shadow, 0, double_buffer, kBoardConfigTotalSize) == kBoardConfigTotalSize){
+                image_status_t image_status = ValidateImage(double_buffer);
+                if(image_status == kImageStatus_Valid){
+                    mBoardConfigPrintInfo("Loaded config");
+#ifdef kBoardConfig_HeaderAddressOffset
+                    // Image predates the header, add it so the next boot takes the fast path.
+                    uint8_t header[kBoardConfig_HeaderSize];
+                    BuildHeader(double_buffer, header);
+                    SHADOW_MEMORY_WriteThrough(&instance->shadow, kBoardConfig_HeaderAddressOffset, header, kBoardConfig_HeaderSize);
+#endif
                 }
-                else if (mHTONS(userCRC) != *((uint16_t*)(double_buffer + kBoardConfig_User_CRC)))
-                {
-                    mBoardConfigPrintWarning("Bad user CRC");
-                    config_valid = false;
+                else if((image_status == kImageStatus_OtherLayout) && Migrate(instance, config)){
+                    mBoardConfigPrintInfo("Migrated config");
                 }
-                else
-                {
-                    mBoardConfigPrintInfo("Loaded config");
-                    config_valid = true;
+                else{
+                    ForceDefaults(instance);
                 }
+            }
+            status = 0;
+            instance->init_done = true;
+        }
+    }
+    return status;
+}
 
-                if (config_valid == false)
-                {
-                    mBoardConfigPrintInfo("Force defaults");
-                    config->get_defaults(double_buffer, sizeof(double_buffer));
-                    Write(0, double_buffer, sizeof(double_buffer));
-                    Commit();
+int BoardConfigInstance_Verify(board_config_t* instance){
+    int status = -1;
+    if(instance && instance->init_done){
+        bool ran = false;
+        bool valid = false;
+        // Checked and reserved under the lock so Begin cannot stage writes in double_buffer meanwhile.
+        Lock(instance);
+        if(!instance->in_transaction && !instance->double_buffer_busy){
+            ran = true;
+            instance->double_buffer_busy = true;
+            if(LoadChunks(instance, ChunkMask(0, kBoardConfigTotalSize)) == 0){
+                valid = (ValidateImage(instance->memory) == kImageStatus_Valid);
+#ifdef kBoardConfig_HeaderAddressOffset
+                if(valid){
+                    uint8_t header[kBoardConfig_HeaderSize];
+                    BuildHeader(instance->memory, header);
+                    if(memcmp(header, instance->memory + kBoardConfig_HeaderAddressOffset, kBoardConfig_HeaderSize) != 0){
+                        mBoardConfigPrintWarning("Bad header");
+                        valid = false;
+                    }
                 }
+#endif
+            }
+        }
+        Unlock(instance);
+        if(ran){
+            if(valid){
+                status = 0;
+            }
+            else{
+                ForceDefaults(instance);
             }
+            ReleaseDoubleBuffer(instance);
+        }
+    }
+    return status;
+}
+
+int BoardConfigInstance_Begin(board_config_t* instance){
+    int status = -1;
+    if(instance && instance->init_done){
+        Lock(instance);
+        if(!instance->in_transaction && !instance->double_buffer_busy && (LoadChunks(instance, ChunkMask(0, kBoardConfigTotalSize)) == 0)){
+            // Stage in the double buffer, readers keep seeing the committed shadow until End.
+            memcpy(instance->double_buffer, instance->shadow.memory, kBoardConfigTotalSize);
+            instance->transaction_chunks = 0;
+            instance->in_transaction = true;
             status = 0;
-            init_done = true;
         }
+        Unlock(instance);
     }
     return status;
 }
 
-int BoardConfig_Commit(void){
+int BoardConfigInstance_End(board_config_t* instance){
     int status = -1;
-    if(init_done){
-        status = Commit();
+    if(instance && instance->init_done){
+        Lock(instance);
+        if(instance->in_transaction){
+            uint32_t dirty_chunks = instance->transaction_chunks;
+            status = 0;
+            if(dirty_chunks){
+                // The CRCs also cover the shadow writes not committed before Begin, they are in double_buffer too.
+                dirty_chunks |= instance->uncommitted_chunks | UpdateChecksums(instance->double_buffer);
+                // Publish and write only the dirty chunks, one medium write per run of consecutive chunks.
+                for(uint32_t chunk = 0; chunk < kChunkCount; chunk++){
+                    if(dirty_chunks & (1UL << chunk)){
+                        uint32_t offset = chunk * kChunkSize;
+                        uint32_t size = ((offset + kChunkSize) > kBoardConfigTotalSize) ? (kBoardConfigTotalSize - offset) : kChunkSize;
+                        memcpy(instance->shadow.memory + offset, instance->double_buffer + offset, size);
+                    }
+                }
+                status = FlushChunks(instance, dirty_chunks);
+                if(status == 0){
+                    instance->uncommitted_chunks = 0;
+                }
+            }
+            instance->in_transaction = false;
+        }
+        Unlock(instance);
     }
     return status;
 }
 
-int BoardConfig_Write(uint32_t inAddress, const uint8_t* inData, uint32_t inSize){
+int BoardConfigInstance_Commit(board_config_t* instance){
     int status = -1;
-    if(init_done){
-        status = Write(inAddress, inData, inSize);
+    if(instance && instance->init_done && ReserveDoubleBuffer(instance)){
+        status = Commit(instance, ChunkMask(0, kBoardConfigTotalSize));
+        ReleaseDoubleBuffer(instance);
     }
     return status;
 }
 
-int BoardConfig_Read(uint32_t inAddress, uint8_t* outData, uint32_t inSize){
+int BoardConfigInstance_Write(board_config_t* instance, uint32_t inAddress, const uint8_t* inData, uint32_t inSize){
     int status = -1;
-    if(init_done){
-        if(SHADOW_MEMORY_Read(&shadow, inAddress, outData, inSize) == inSize){
+    if(instance && instance->init_done && inData && (inAddress < kBoardConfigTotalSize) && (inSize <= (kBoardConfigTotalSize - inAddress))){
+        // in_transaction is checked under the lock so the write cannot race with Begin / End.
+        Lock(instance);
+        if(instance->in_transaction){
+            memcpy(instance->double_buffer + inAddress, inData, inSize);
+            instance->transaction_chunks |= ChunkMask(inAddress, inSize);
+            status = 0;
+        }
+        else if(LoadChunks(instance, ChunkMask(inAddress, inSize)) == 0){
+            memcpy(instance->shadow.memory + inAddress, inData, inSize);
+            instance->uncommitted_chunks |= ChunkMask(inAddress, inSize);
             status = 0;
         }
+        Unlock(instance);
     }
     return status;
 }
 
-static int Write(uint32_t inAddress, const uint8_t* inData, uint32_t inSize){
+int BoardConfigInstance_Read(board_config_t* instance, uint32_t inAddress, uint8_t* outData, uint32_t inSize){
     int status = -1;
-    if(SHADOW_MEMORY_Write(&shadow, inAddress, inData, inSize) == inSize){
+    if(instance && instance->init_done){
+        if(Load(instance, inAddress, inSize) == 0){
+            if(SHADOW_MEMORY_Read(&instance->shadow, inAddress, outData, inSize) == inSize){
+                status = 0;
+            }
+        }
+    }
+    return status;
+}
+
+uint8_t* BoardConfigInstance_AcquireShadow(board_config_t* instance, uint32_t inAddress, uint32_t inSize){
+    uint8_t* memory = NULL;
+    if(instance && instance->init_done){
+        Lock(instance);
+        if((instance->pending_chunks == 0) || (LoadChunks(instance, ChunkMask(inAddress, inSize)) == 0)){
+            memory = instance->shadow.memory;
+        }
+        else{
+            Unlock(instance);
+        }
+    }
+    return memory;
+}
+
+uint8_t* BoardConfigInstance_AcquireShadowForWrite(board_config_t* instance, uint32_t inAddress, uint32_t inSize){
+    uint8_t* memory = BoardConfigInstance_AcquireShadow(instance, inAddress, inSize);
+    if(memory && instance->in_transaction){
+        instance->transaction_chunks |= ChunkMask(inAddress, inSize);
+        memory = instance->double_buffer;
+    }
+    else if(memory){
+        instance->uncommitted_chunks |= ChunkMask(inAddress, inSize);
+    }
+    return memory;
+}
+
+void BoardConfigInstance_ReleaseShadow(board_config_t* instance){
+    if(instance && instance->init_done){
+        Unlock(instance);
+    }
+}
+
+board_config_t* BoardConfig_DefaultInstance(void){
+    return &default_instance;
+}
+
+int BoardConfig_Init(board_config_config_t* config){
+    return BoardConfigInstance_Init(&default_instance, config);
+}
+
+int BoardConfig_Verify(void){
+    return BoardConfigInstance_Verify(&default_instance);
+}
+
+int BoardConfig_Begin(void){
+    return BoardConfigInstance_Begin(&default_instance);
+}
+
+int BoardConfig_End(void){
+    return BoardConfigInstance_End(&default_instance);
+}
+
+int BoardConfig_Commit(void){
+    return BoardConfigInstance_Commit(&default_instance);
+}
+
+int BoardConfig_Write(uint32_t inAddress, const uint8_t* inData, uint32_t inSize){
+    return BoardConfigInstance_Write(&default_instance, inAddress, inData, inSize);
+}
+
+int BoardConfig_Read(uint32_t inAddress, uint8_t* outData, uint32_t inSize){
+    return BoardConfigInstance_Read(&default_instance, inAddress, outData, inSize);
+}
+
+uint8_t* BoardConfig_AcquireShadow(uint32_t inAddress, uint32_t inSize){
+    return BoardConfigInstance_AcquireShadow(&default_instance, inAddress, inSize);
+}
+
+uint8_t* BoardConfig_AcquireShadowForWrite(uint32_t inAddress, uint32_t inSize){
+    return BoardConfigInstance_AcquireShadowForWrite(&default_instance, inAddress, inSize);
+}
+
+void BoardConfig_ReleaseShadow(void){
+    BoardConfigInstance_ReleaseShadow(&default_instance);
+}
+
+static int Write(board_config_t* instance, uint32_t inAddress, const uint8_t* inData, uint32_t inSize){
+    int status = -1;
+    if(SHADOW_MEMORY_Write(&instance->shadow, inAddress, inData, inSize) == inSize){
         status = 0;
     }
     return status;
 }
 
-static int Commit(void){
+// Update the CRCs and header then write the dirty chunks to the medium, the chunks holding a CRC or header field
+// that changed and the uncommitted shadow writes are added to them.
+static int Commit(board_config_t* instance, uint32_t dirty_chunks){
     int status = -1;
-    if(SHADOW_MEMORY_Read(&shadow, 0, double_buffer, kBoardConfigTotalSize) == kBoardConfigTotalSize){
-        uint16_t crc = mHTONS(CRC16ComputeCRC(0, (uint8_t*)(double_buffer + kBoardConfig_FactoryAddressOffset), kBoardConfig_FactorySize));
-        if(SHADOW_MEMORY_Write(&shadow, kBoardConfig_Factory_CRC, (uint8_t*)(&crc), 2) == 2){
-            crc = mHTONS(CRC16ComputeCRC(0, (uint8_t*)(double_buffer + kBoardConfig_UserAddressOffset), kBoardConfig_UserSize));
-            if(SHADOW_MEMORY_Write(&shadow, kBoardConfig_User_CRC, (uint8_t*)(&crc), 2) == 2){
-                if(SHADOW_MEMORY_Flush(&shadow) == kBoardConfigTotalSize){
-                    status = 0;
+    uint8_t* double_buffer = instance->double_buffer;
+    if(Load(instance, 0, kBoardConfigTotalSize) == 0){
+        if(SHADOW_MEMORY_Read(&instance->shadow, 0, double_buffer, kBoardConfigTotalSize) == kBoardConfigTotalSize){
+            uint32_t changed_chunks = UpdateChecksums(double_buffer);
+            status = 0;
+            if(changed_chunks){
+                for(uint32_t section = 0; (section < kSectionCount) && (status == 0); section++){
+                    status = Write(instance, sections[section].crc_offset, double_buffer + sections[section].crc_offset, 2);
+                }
+#ifdef kBoardConfig_HeaderAddressOffset
+                if(status == 0){
+                    status = Write(instance, kBoardConfig_HeaderAddressOffset, double_buffer + kBoardConfig_HeaderAddressOffset, kBoardConfig_HeaderSize);
                 }
+#endif
+                dirty_chunks |= changed_chunks;
+            }
+            if(status == 0){
+                Lock(instance);
+                dirty_chunks |= instance->uncommitted_chunks;
+                Unlock(instance);
+                if(dirty_chunks == ChunkMask(0, kBoardConfigTotalSize)){
+                    if(SHADOW_MEMORY_Flush(&instance->shadow) != kBoardConfigTotalSize){
+                        status = -1;
+                    }
+                }
+                else{
+                    Lock(instance);
+                    status = FlushChunks(instance, dirty_chunks);
+                    Unlock(instance);
+                }
+                if(status == 0){
+                    Lock(instance);
+                    instance->uncommitted_chunks &= ~dirty_chunks;
+                    Unlock(instance);
+                }
+            }
+        }
+    }
+    return status;
+}
+
+// Update the CRC and header fields of image, returns the chunks where they changed.
+static uint32_t UpdateChecksums(uint8_t* image){
+    uint32_t changed_chunks = 0;
+    for(uint32_t section = 0; section < kSectionCount; section++){
+        uint16_t crc = mHTONS(CRC16ComputeCRC(0, (uint8_t*)(image + sections[section].offset), sections[section].size));
+        if(memcmp(image + sections[section].crc_offset, &crc, 2) != 0){
+            memcpy(image + sections[section].crc_offset, &crc, 2);
+            changed_chunks |= ChunkMask(sections[section].crc_offset, 2);
+        }
+    }
+#ifdef kBoardConfig_HeaderAddressOffset
+    uint8_t header[kBoardConfig_HeaderSize];
+    BuildHeader(image, header);
+    if(memcmp(image + kBoardConfig_HeaderAddressOffset, header, kBoardConfig_HeaderSize) != 0){
+        memcpy(image + kBoardConfig_HeaderAddressOffset, header, kBoardConfig_HeaderSize);
+        changed_chunks |= ChunkMask(kBoardConfig_HeaderAddressOffset, kBoardConfig_HeaderSize);
+    }
+#endif
+    return changed_chunks;
+}
+
+static image_status_t ValidateImage(const uint8_t* image){
+    image_status_t image_status = kImageStatus_Valid;
+    if (*(uint16_t*)(image + kBoardConfig_Factory_Magic) != mHTONS(kBoardConfig_MagicNumber))
+    {
+        mBoardConfigPrintWarning("Bad magic");
+        image_status = kImageStatus_Invalid;
+    }
+    else
+    {
+        for (uint32_t section = 0; (section < kSectionCount) && (image_status == kImageStatus_Valid); section++)
+        {
+            uint16_t crc = CRC16ComputeCRC(0, (uint8_t*)(image + sections[section].offset), sections[section].size);
+            if (mHTONS(crc) != *((uint16_t*)(image + sections[section].crc_offset)))
+            {
+                mBoardConfigPrintWarning("Bad section CRC");
+                image_status = kImageStatus_Invalid;
+            }
+        }
+    }
+
+    if ((image_status == kImageStatus_Valid) && (image[kBoardConfig_Factory_FlashLayout] != kVersionConfigLayout))
+    {
+        mBoardConfigPrintWarning("Bad layout");
+        image_status = kImageStatus_OtherLayout;
+    }
+    return image_status;
+}
+
+static void ForceDefaults(board_config_t* instance){
+    mBoardConfigPrintInfo("Force defaults");
+    instance->get_defaults(instance->double_buffer, kBoardConfigTotalSize);
+    // Chunks a failed load left pending must not be read back over the defaults by Commit.
+    Lock(instance);
+    instance->pending_chunks = 0;
+    Unlock(instance);
+    Write(instance, 0, instance->double_buffer, kBoardConfigTotalSize);
+    Commit(instance, ChunkMask(0, kBoardConfigTotalSize));
+}
+
+// Shadow holds a valid image in another layout, apply the migrations up to kVersionConfigLayout and commit only the
+// chunks they modified.
+static bool Migrate(board_config_t* instance, const board_config_config_t* config){
+    uint8_t* double_buffer = instance->double_buffer;
+    uint32_t dirty_chunks = 0;
+    uint8_t layout = double_buffer[kBoardConfig_Factory_FlashLayout];
+    // Bound the chain in case the table has a cycle.
+    for(uint32_t step = 0; (step < config->migration_count) && (layout != kVersionConfigLayout); step++){
+        const board_config_migration_t* migration = NULL;
+        for(uint32_t migrationIdx = 0; migrationIdx < config->migration_count; migrationIdx++){
+            if(config->migrations[migrationIdx].from_layout == layout){
+                migration = &config->migrations[migrationIdx];
+                break;
+            }
+        }
+        if(migration == NULL){
+            break;
+        }
+
+        // Moves read the image as it was before this step, then defaults are applied.
+        bool from_defaults = false;
+        if(SHADOW_MEMORY_Read(&instance->shadow, 0, double_buffer, kBoardConfigTotalSize) != kBoardConfigTotalSize){
+            return false;
+        }
+        for(uint32_t moveIdx = 0; moveIdx < migration->move_count; moveIdx++){
+            const board_config_move_t* move = &migration->moves[moveIdx];
+            if(move->old_offset == kBoardConfigMigration_FromDefaults){
+                from_defaults = true;
+            }
+            else if((move->old_offset + move->size) <= kBoardConfigTotalSize){
+                if(Write(instance, move->new_offset, double_buffer + move->old_offset, move->size) != 0){
+                    return false;
+                }
+                dirty_chunks |= ChunkMask(move->new_offset, move->size);
+            }
+        }
+        if(from_defaults){
+            instance->get_defaults(double_buffer, kBoardConfigTotalSize);
+            for(uint32_t moveIdx = 0; moveIdx < migration->move_count; moveIdx++){
+                const board_config_move_t* move = &migration->moves[moveIdx];
+                if(move->old_offset == kBoardConfigMigration_FromDefaults){
+                    if(Write(instance, move->new_offset, double_buffer + move->new_offset, move->size) != 0){
+                        return false;
+                    }
+                    dirty_chunks |= ChunkMask(move->new_offset, move->size);
+                }
+            }
+        }
+
+        layout = migration->to_layout;
+        if(Write(instance, kBoardConfig_Factory_FlashLayout, &layout, 1) != 0){
+            return false;
+        }
+        dirty_chunks |= ChunkMask(kBoardConfig_Factory_FlashLayout, 1);
+    }
+
+    return (layout == kVersionConfigLayout) && (Commit(instance, dirty_chunks) == 0);
+}
+
+static int Load(board_config_t* instance, uint32_t inAddress, uint32_t inSize){
+    int status = 0;
+    if(instance->pending_chunks){
+        Lock(instance);
+        status = LoadChunks(instance, ChunkMask(inAddress, inSize));
+        Unlock(instance);
+    }
+    return status;
+}
+
+// Shadow must be locked.
+static int LoadChunks(board_config_t* instance, uint32_t mask){
+    int status = 0;
+    mask &= instance->pending_chunks;
+    for(uint32_t chunk = 0; mask && (chunk < kChunkCount); chunk++){
+        if(mask & (1UL << chunk)){
+            // Merge consecutive pending chunks in a single medium read.
+            uint32_t first = chunk;
+            while(((chunk + 1) < kChunkCount) && (mask & (1UL << (chunk + 1)))){
+                chunk++;
+            }
+            uint32_t offset = first * kChunkSize;
+            uint32_t size = (chunk + 1) * kChunkSize - offset;
+            if((offset + size) > kBoardConfigTotalSize){
+                size = kBoardConfigTotalSize - offset;
+            }
+            if(instance->shadow.read_from_medium(instance->shadow.offset_on_medium + offset, instance->shadow.memory + offset, size) == size){
+                uint32_t loaded = ChunkMask(offset, size);
+                instance->pending_chunks &= ~loaded;
+                mask &= ~loaded;
+            }
+            else{
+                status = -1;
             }
         }
     }
     return status;
 }
+
+// Shadow must be locked.
+static int FlushChunks(board_config_t* instance, uint32_t mask){
+    int status = 0;
+    for(uint32_t chunk = 0; mask && (chunk < kChunkCount); chunk++){
+        if(mask & (1UL << chunk)){
+            // Merge consecutive dirty chunks in a single medium write.
+            uint32_t first = chunk;
+            while(((chunk + 1) < kChunkCount) && (mask & (1UL << (chunk + 1)))){
+                chunk++;
+            }
+            uint32_t offset = first * kChunkSize;
+            uint32_t size = (chunk + 1) * kChunkSize - offset;
+            if((offset + size) > kBoardConfigTotalSize){
+                size = kBoardConfigTotalSize - offset;
+            }
+            if(instance->shadow.write_to_medium(instance->shadow.offset_on_medium + offset, instance->shadow.memory + offset, size) != size){
+                status = -1;
+            }
+            mask &= ~ChunkMask(offset, size);
+        }
+    }
+    return status;
+}
+
+static uint32_t ChunkMask(uint32_t inAddress, uint32_t inSize){
+    uint32_t mask = 0;
+    if(inSize && (inAddress < kBoardConfigTotalSize)){
+        uint32_t last = inAddress + inSize - 1;
+        if((last >= kBoardConfigTotalSize) || (last < inAddress)){
+            last = kBoardConfigTotalSize - 1;
+        }
+        for(uint32_t chunk = inAddress / kChunkSize; chunk <= (last / kChunkSize); chunk++){
+            mask |= (1UL << chunk);
+        }
+    }
+    return mask;
+}
+
+static void Lock(board_config_t* instance){
+    if(instance->shadow.lock){
+        instance->shadow.lock(instance->shadow.shadow_lock);
+    }
+}
+
+static void Unlock(board_config_t* instance){
+    if(instance->shadow.unlock){
+        instance->shadow.unlock(instance->shadow.shadow_lock);
+    }
+}
+
+// Commit and ForceDefaults use double_buffer outside the lock, reserve it unless a transaction stages writes in it.
+static bool ReserveDoubleBuffer(board_config_t* instance){
+    bool reserved = false;
+    Lock(instance);
+    if(!instance->in_transaction && !instance->double_buffer_busy){
+        instance->double_buffer_busy = true;
+        reserved = true;
+    }
+    Unlock(instance);
+    return reserved;
+}
+
+static void ReleaseDoubleBuffer(board_config_t* instance){
+    Lock(instance);
+    instance->double_buffer_busy = false;
+    Unlock(instance);
+}
+
+#ifdef kBoardConfig_HeaderAddressOffset
+static bool ReadHeader(board_config_t* instance){
+    bool valid = false;
+    uint8_t header[kBoardConfig_HeaderSize];
+    if(SHADOW_MEMORY_ReadThrough(&instance->shadow, kBoardConfig_HeaderAddressOffset, header, kBoardConfig_HeaderSize) == kBoardConfig_HeaderSize){
+        uint16_t digest = mHTONS(CRC16ComputeCRC(0, header, kHeader_Digest));
+        if (*(uint16_t*)(header + kHeader_Magic) != mHTONS(kBoardConfig_MagicNumber))
+        {
+            mBoardConfigPrintWarning("Bad header magic");
+        }
+        else if (header[kHeader_Layout] != kVersionConfigLayout)
+        {
+            mBoardConfigPrintWarning("Bad header layout");
+        }
+        else if (digest != *(uint16_t*)(header + kHeader_Digest))
+        {
+            mBoardConfigPrintWarning("Bad header digest");
+        }
+        else
+        {
+            valid = true;
+        }
+    }
+    return valid;
+}
+
+// CRC fields of the image must be up to date.
+static void BuildHeader(const uint8_t* image, uint8_t* header){
+    memset(header, 0, kBoardConfig_HeaderSize);
+    *(uint16_t*)(header + kHeader_Magic) = mHTONS(kBoardConfig_MagicNumber);
+    header[kHeader_Layout] = kVersionConfigLayout;
+    for(uint32_t section = 0; section < kSectionCount; section++){
+        memcpy(header + kHeader_SectionCRC + 2 * section, image + sections[section].crc_offset, 2);
+    }
+    uint16_t digest = mHTONS(CRC16ComputeCRC(0, header, kHeader_Digest));
+    memcpy(header + kHeader_Digest, &digest, 2);
+}
+#endif
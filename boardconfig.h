@@ -21,6 +21,14 @@
 
 // Standard includes.
 #include <stdint.h>
+#include <stdbool.h>
+
+// Lib includes.
+#include "shadow_memory.h"
+
+// Optional header for fast boot validation, define kBoardConfig_HeaderAddressOffset (outside of the factory and
+// user sections) in iomodconfig.h to enable it: magic, layout, section CRCs and their digest.
+#define kBoardConfig_HeaderSize 10
 
 typedef uint32_t (*BoardConfig_WriteToMedium)(uint32_t address, const uint8_t* data, uint32_t size);
 typedef uint32_t (*BoardConfig_ReadFromMedium)(uint32_t address, uint8_t* destination, uint32_t size);
@@ -30,6 +38,25 @@ typedef void (*BoardConfig_Unlock)(void* lock);
 
 typedef void (*BoardConfig_GetDefault)(uint8_t* destination, uint32_t destination_size);
 
+// Layout migration, applied when the stored layout differs from kVersionConfigLayout. Each move copies size bytes
+// from old_offset in the from_layout image to new_offset, or from the defaults when old_offset is
+// kBoardConfigMigration_FromDefaults. Bytes not covered by a move keep their offset. Sections and CRC locations
+// must be the same in both layouts.
+#define kBoardConfigMigration_FromDefaults 0xFFFFFFFF
+
+typedef struct{
+    uint32_t old_offset;
+    uint32_t new_offset;
+    uint32_t size;
+}board_config_move_t;
+
+typedef struct{
+    uint8_t from_layout;
+    uint8_t to_layout;
+    const board_config_move_t* moves;
+    uint32_t move_count;
+}board_config_migration_t;
+
 typedef struct{
     BoardConfig_WriteToMedium write_to_medium;
     BoardConfig_ReadFromMedium read_from_medium;
@@ -38,14 +65,77 @@ typedef struct{
     void* shadow_lock;
     BoardConfig_Lock lock;
     BoardConfig_Unlock unlock;
+    const board_config_migration_t* migrations;
+    uint32_t migration_count;
 }board_config_config_t;
 
+typedef struct{
+    //Mandatory, set before BoardConfigInstance_Init
+    uint8_t* memory;            //kBoardConfigTotalSize bytes
+    uint8_t* double_buffer;     //kBoardConfigTotalSize bytes
+    uint32_t offset_on_medium;
+    //Private
+    shadow_memory_t shadow;
+    BoardConfig_GetDefault get_defaults;
+    uint32_t pending_chunks;    //Not yet loaded from the medium
+    uint32_t transaction_chunks;    //Staged in double_buffer
+    uint32_t uncommitted_chunks;    //Written in the shadow, not yet on the medium
+    bool in_transaction;
+    bool double_buffer_busy;    //Used by Commit or Verify, Begin is refused
+    bool init_done;
+}board_config_t;
+
+// Instance API, each instance owns its own shadow and lock so several config stores can live in one process.
+// With the header enabled, Init only validates the header and the body is loaded on first access.
+int BoardConfigInstance_Init(board_config_t* instance, board_config_config_t* config);
+
+// Load the whole body and check it against the header, restores the defaults if invalid. Can run in a background task.
+// Returns 0 if valid, -1 if invalid or a transaction or another Verify / Commit is running.
+int BoardConfigInstance_Verify(board_config_t* instance);
+
+// Transaction: writes between Begin and End are staged and readers see the previous values. End updates the CRCs
+// and writes the modified chunks to the medium, one write per run, with the shadow writes not committed before Begin
+// since the CRCs cover them. Commit is refused while a transaction is open.
+int BoardConfigInstance_Begin(board_config_t* instance);
+
+int BoardConfigInstance_End(board_config_t* instance);
+
+int BoardConfigInstance_Commit(board_config_t* instance);
+
+int BoardConfigInstance_Write(board_config_t* instance, uint32_t inAddress, const uint8_t* inData, uint32_t inSize);
+
+int BoardConfigInstance_Read(board_config_t* instance, uint32_t inAddress, uint8_t* outData, uint32_t inSize);
+
+uint8_t* BoardConfigInstance_AcquireShadow(board_config_t* instance, uint32_t inAddress, uint32_t inSize);
+
+uint8_t* BoardConfigInstance_AcquireShadowForWrite(board_config_t* instance, uint32_t inAddress, uint32_t inSize);
+
+void BoardConfigInstance_ReleaseShadow(board_config_t* instance);
+
+// Default instance API, stored at kBoardConfigStartAddress.
+board_config_t* BoardConfig_DefaultInstance(void);
+
 int BoardConfig_Init(board_config_config_t* config);
 
+int BoardConfig_Verify(void);
+
+int BoardConfig_Begin(void);
+
+int BoardConfig_End(void);
+
 int BoardConfig_Commit(void);
 
 int BoardConfig_Write(uint32_t inAddress, const uint8_t* inData, uint32_t inSize);
 
 int BoardConfig_Read(uint32_t inAddress, uint8_t* outData, uint32_t inSize);
 
+// Direct access to the shadow for fixed-size copies (see boardconfigschema.h), the range is loaded if needed.
+// Returns NULL on error, otherwise the shadow is locked until BoardConfig_ReleaseShadow is called.
+uint8_t* BoardConfig_AcquireShadow(uint32_t inAddress, uint32_t inSize);
+
+// Same for writing, returns the staging buffer when a transaction is open.
+uint8_t* BoardConfig_AcquireShadowForWrite(uint32_t inAddress, uint32_t inSize);
+
+void BoardConfig_ReleaseShadow(void);
+
 #endif // BOARDCONFIG_H_
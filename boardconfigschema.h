@@ -0,0 +1,188 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef BOARDCONFIGSCHEMA_H_
+#define BOARDCONFIGSCHEMA_H_
+
+// Standard includes.
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Lib includes.
+#include "boardconfig.h"
+#include "iomodconfig.h"
+#include "iomodutils.h"
+#include "version.h"
+#include "boardconfiguser.h"
+
+// The schema is declared in boardconfiguser.h (see README.md):
+//   kBoardConfigSchemaSections(mSection): mSection(section) for each section, in image order.
+//   kBoardConfigSchema_<section>(mField): mField(section, name, type, default) for each field, in image order.
+// Each section is stored at kBoardConfig_<section>AddressOffset and must fit in kBoardConfig_<section>Size (iomodconfig.h).
+#ifndef kBoardConfigSchemaSections
+#error "Board config schema not defined (ex: #define kBoardConfigSchemaSections(mSection) mSection(Factory) mSection(User))."
+#endif
+
+// ----------------------------------------------------------------------------
+// Layout
+// ----------------------------------------------------------------------------
+// Fields are stored as byte arrays so the layout has no padding and offsetof() gives the offset in the image.
+// Each section is placed at its configured offset, the bytes before it (magic, layout, CRCs and the other sections)
+// are reserved.
+#define mBoardConfigSchemaFieldBytes(section, name, type, defaultValue) uint8_t name[sizeof(type)];
+#define mBoardConfigSchemaSectionLayout(section) typedef struct { kBoardConfigSchema_##section(mBoardConfigSchemaFieldBytes) } BoardConfigSchema_##section##_t;
+#define mBoardConfigSchemaSectionMember(section) struct { uint8_t reserved[kBoardConfig_##section##AddressOffset]; BoardConfigSchema_##section##_t fields; } section;
+
+kBoardConfigSchemaSections(mBoardConfigSchemaSectionLayout)
+
+typedef union
+{
+    uint8_t image[kBoardConfigTotalSize];
+    kBoardConfigSchemaSections(mBoardConfigSchemaSectionMember)
+} BoardConfigSchema_t;
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+// Section index, ex: kBoardConfigSchemaSection_User.
+#define mBoardConfigSchemaSectionIndex(section) kBoardConfigSchemaSection_##section,
+typedef enum
+{
+    kBoardConfigSchemaSections(mBoardConfigSchemaSectionIndex)
+    // Reserved for future use, keep last.
+    kBoardConfigSchemaSection_Max,
+} BoardConfigSchemaSection_e;
+
+// Offsets in the image, sizes and section membership, ex: kBoardConfigSchema_User_Gain_Offset.
+#define mBoardConfigSchemaFieldConstants(section, name, type, defaultValue) \
+    kBoardConfigSchema_##section##_##name##_Offset = offsetof(BoardConfigSchema_t, section.fields.name), \
+    kBoardConfigSchema_##section##_##name##_Size = sizeof(type), \
+    kBoardConfigSchema_##section##_##name##_Section = kBoardConfigSchemaSection_##section,
+#define mBoardConfigSchemaSectionConstants(section) \
+    kBoardConfigSchema_##section##_Offset = offsetof(BoardConfigSchema_t, section.fields), \
+    kBoardConfigSchema_##section##_Size = sizeof(BoardConfigSchema_##section##_t), \
+    kBoardConfigSchema_##section(mBoardConfigSchemaFieldConstants)
+enum
+{
+    kBoardConfigSchemaSections(mBoardConfigSchemaSectionConstants)
+    kBoardConfigSchema_TotalSize = sizeof(BoardConfigSchema_t),
+};
+
+// ----------------------------------------------------------------------------
+// Checks
+// ----------------------------------------------------------------------------
+#ifdef __cplusplus
+#define mBoardConfigSchemaStaticAssert(expr, message) static_assert(expr, message)
+#else
+#define mBoardConfigSchemaStaticAssert(expr, message) _Static_assert(expr, message)
+#endif
+
+// True if the size bytes at offset are outside of the section region.
+#define mBoardConfigSchemaOutsideSection(section, offset, size) \
+    ((((offset) + (size)) <= kBoardConfig_##section##AddressOffset) || \
+     ((offset) >= (kBoardConfig_##section##AddressOffset + kBoardConfig_##section##Size)))
+
+#ifdef kBoardConfig_HeaderAddressOffset
+#define mBoardConfigSchemaOutsideHeader(section) mBoardConfigSchemaOutsideSection(section, kBoardConfig_HeaderAddressOffset, kBoardConfig_HeaderSize)
+#else
+#define mBoardConfigSchemaOutsideHeader(section) 1
+#endif
+
+// Each section must fit its region, which must not hold the magic, layout, CRC or header words.
+#define mBoardConfigSchemaSectionChecks(section) \
+    mBoardConfigSchemaStaticAssert(sizeof(BoardConfigSchema_##section##_t) <= kBoardConfig_##section##Size, "Board config schema section " #section " does not fit in its region"); \
+    mBoardConfigSchemaStaticAssert((kBoardConfig_##section##AddressOffset + kBoardConfig_##section##Size) <= kBoardConfigTotalSize, "Board config region " #section " does not fit in kBoardConfigTotalSize"); \
+    mBoardConfigSchemaStaticAssert(mBoardConfigSchemaOutsideSection(section, kBoardConfig_Factory_Magic, 2) && \
+                                   mBoardConfigSchemaOutsideSection(section, kBoardConfig_Factory_FlashLayout, 1) && \
+                                   mBoardConfigSchemaOutsideSection(section, kBoardConfig_Factory_CRC, 2) && \
+                                   mBoardConfigSchemaOutsideSection(section, kBoardConfig_User_CRC, 2) && \
+                                   mBoardConfigSchemaOutsideHeader(section), "Board config region " #section " overlaps the magic, layout, CRC or header words");
+
+kBoardConfigSchemaSections(mBoardConfigSchemaSectionChecks)
+
+mBoardConfigSchemaStaticAssert(sizeof(BoardConfigSchema_t) == kBoardConfigTotalSize, "Board config schema does not match kBoardConfigTotalSize");
+
+// ----------------------------------------------------------------------------
+// Accessors
+// ----------------------------------------------------------------------------
+// Typed getter / setter for each field, ex: BoardConfig_Get_User_Gain(uint16_t* outValue) on the default instance
+// and BoardConfigInstance_Get_User_Gain(board_config_t* instance, uint16_t* outValue).
+// Offsets and sizes are constants, each access is a single fixed-size copy into / from the shadow.
+#define mBoardConfigSchemaFieldAccessors(section, name, type, defaultValue) \
+static inline int BoardConfigInstance_Get_##section##_##name(board_config_t* instance, type* outValue) \
+{ \
+    uint8_t* shadow = BoardConfigInstance_AcquireShadow(instance, kBoardConfigSchema_##section##_##name##_Offset, sizeof(type)); \
+    if (shadow == NULL) \
+    { \
+        return -1; \
+    } \
+    memcpy(outValue, shadow + kBoardConfigSchema_##section##_##name##_Offset, sizeof(type)); \
+    BoardConfigInstance_ReleaseShadow(instance); \
+    return 0; \
+} \
+static inline int BoardConfigInstance_Set_##section##_##name(board_config_t* instance, const type* inValue) \
+{ \
+    uint8_t* shadow = BoardConfigInstance_AcquireShadowForWrite(instance, kBoardConfigSchema_##section##_##name##_Offset, sizeof(type)); \
+    if (shadow == NULL) \
+    { \
+        return -1; \
+    } \
+    memcpy(shadow + kBoardConfigSchema_##section##_##name##_Offset, inValue, sizeof(type)); \
+    BoardConfigInstance_ReleaseShadow(instance); \
+    return 0; \
+} \
+static inline int BoardConfig_Get_##section##_##name(type* outValue) \
+{ \
+    return BoardConfigInstance_Get_##section##_##name(BoardConfig_DefaultInstance(), outValue); \
+} \
+static inline int BoardConfig_Set_##section##_##name(const type* inValue) \
+{ \
+    return BoardConfigInstance_Set_##section##_##name(BoardConfig_DefaultInstance(), inValue); \
+}
+#define mBoardConfigSchemaSectionAccessors(section) kBoardConfigSchema_##section(mBoardConfigSchemaFieldAccessors)
+
+kBoardConfigSchemaSections(mBoardConfigSchemaSectionAccessors)
+
+// ----------------------------------------------------------------------------
+// Defaults
+// ----------------------------------------------------------------------------
+#define mBoardConfigSchemaFieldDefault(section, name, type, defaultValue) \
+    { \
+        static const type kDefault = defaultValue; \
+        memcpy(destination + kBoardConfigSchema_##section##_##name##_Offset, &kDefault, sizeof(type)); \
+    }
+#define mBoardConfigSchemaSectionDefaults(section) kBoardConfigSchema_##section(mBoardConfigSchemaFieldDefault)
+
+/// Fill destination with the magic, layout and schema defaults, unused bytes are zeroed. The CRCs are computed by
+/// the commit. Can be used as board_config_config_t.get_defaults.
+static inline void BoardConfig_SchemaGetDefaults(uint8_t* destination, uint32_t destination_size)
+{
+    if (destination_size < kBoardConfigSchema_TotalSize)
+    {
+        return;
+    }
+
+    uint16_t magic = mHTONS(kBoardConfig_MagicNumber);
+    memset(destination, 0, destination_size);
+    memcpy(destination + kBoardConfig_Factory_Magic, &magic, sizeof(magic));
+    destination[kBoardConfig_Factory_FlashLayout] = kVersionConfigLayout;
+    kBoardConfigSchemaSections(mBoardConfigSchemaSectionDefaults)
+}
+
+#endif // BOARDCONFIGSCHEMA_H_
@@ -24,6 +24,14 @@
 #include "conversion.h"
 #include "utils.h"
 
+// Offset folded for negatives voltages monitoring.
+#define kConversionNegativeOffset 31516
+
+// Gain trim of 0 is a gain of 1.
+#define kConversionGainTrimFractionBits 15
+// Fused multipliers are kept below 2^15 so inData * multiplier fits in 32 bits.
+#define kConversionFusedMultiplierMax ((1 << 15) - 1)
+
 // --------------------------------------------------------------------------------------------------------------
 uint16_t ConversionDecode(uint16_t inData, uint16_t inMultiplier, uint8_t inScale, int8_t inSign)
 {
@@ -39,7 +47,7 @@ uint16_t ConversionDecode(uint16_t inData, uint16_t inMultiplier, uint8_t inScal
     temp_product = inData * inMultiplier;
     result = temp_product >> inScale;
     // For negatives voltages monitoring.
-    (inSign < 0)? result = abs(result - 31516): result;
+    (inSign < 0)? result = abs(result - kConversionNegativeOffset): result;
     roundup = temp_product & (1 << (inScale - 1));
 
     if (result > UINT16_MAX)
@@ -56,18 +64,241 @@ uint16_t ConversionDecode(uint16_t inData, uint16_t inMultiplier, uint8_t inScal
     return (uint16_t)result;
 }
 
+// --------------------------------------------------------------------------------------------------------------
+int ConversionEncode(uint16_t inValue, uint16_t inMultiplier, uint8_t inScale, int8_t inSign, uint16_t* outData)
+{
+    // Negatives voltages monitoring folds around kConversionNegativeOffset.
+    if (inSign < 0)
+    {
+        return -1;
+    }
+
+    // Everything decodes to at most inValue.
+    if (!inScale || !inMultiplier || (inValue == UINT16_MAX))
+    {
+        *outData = UINT16_MAX;
+        return 0;
+    }
+
+    // With rounding, ConversionDecode(x) <= inValue if and only if x * inMultiplier + 2^(inScale - 1) < (inValue + 1) * 2^inScale.
+    uint64_t maxProduct = ((uint64_t)(inValue + 1) << inScale) - (1 << (inScale - 1)) - 1;
+    uint64_t result = maxProduct / inMultiplier;
+
+    *outData = (result > UINT16_MAX) ? UINT16_MAX : (uint16_t)result;
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+int ConversionFuse(const ConversionCalibration_t* inCalibration, ConversionFused_t* outFused)
+{
+    // Multiplier * gain, Q (scale + kConversionGainTrimFractionBits).
+    uint64_t multiplier = (uint64_t)inCalibration->encode.multiplier * (uint32_t)((1 << kConversionGainTrimFractionBits) + inCalibration->gainTrim);
+    int32_t scale = inCalibration->encode.scale + kConversionGainTrimFractionBits;
+
+    if (!inCalibration->encode.scale)
+    {
+        return -1;
+    }
+
+    // Drop the fractional bits that do not fit, rounded. Without trim, only zero bits are dropped.
+    uint8_t shift = 0;
+    while (((multiplier + ((1ULL << shift) >> 1)) >> shift) > kConversionFusedMultiplierMax)
+    {
+        shift ++;
+    }
+    scale -= shift;
+    if ((scale < 1) || (scale > 31))
+    {
+        return -1;
+    }
+
+    outFused->multiplier = (uint16_t)((multiplier + ((1ULL << shift) >> 1)) >> shift);
+    outFused->scale = (uint8_t)scale;
+    outFused->sign = inCalibration->encode.sign;
+    outFused->offset = inCalibration->offset;
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+uint16_t ConversionDecodeFused(uint16_t inData, const ConversionFused_t* inFused)
+{
+    uint32_t product = (uint32_t)inData * inFused->multiplier;
+    int32_t result = (int32_t)(product >> inFused->scale);
+
+    // For negatives voltages monitoring, same as ConversionDecode.
+    if (inFused->sign < 0)
+    {
+        result = abs(result - kConversionNegativeOffset);
+    }
+    // Fract part >= 0.5, round up.
+    result += (product >> (inFused->scale - 1)) & 1;
+    result += inFused->offset;
+
+    if (result < 0)
+    {
+        return 0;
+    }
+    if (result > UINT16_MAX)
+    {
+        return UINT16_MAX;
+    }
+
+    return (uint16_t)result;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+int ConversionEncodeFused(uint16_t inValue, const ConversionFused_t* inFused, uint16_t* outData)
+{
+    // Value before the offset.
+    int32_t value = (int32_t)inValue - inFused->offset;
+
+    if ((inFused->sign < 0) || (value < 0))
+    {
+        return -1;
+    }
+
+    if (!inFused->multiplier || (inValue == UINT16_MAX))
+    {
+        *outData = UINT16_MAX;
+        return 0;
+    }
+
+    // Same as ConversionEncode, the offset is added after rounding.
+    uint64_t maxProduct = ((uint64_t)(value + 1) << inFused->scale) - (1 << (inFused->scale - 1)) - 1;
+    uint64_t result = maxProduct / inFused->multiplier;
+
+    *outData = (result > UINT16_MAX) ? UINT16_MAX : (uint16_t)result;
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+void ConversionDecodeBatch(const uint16_t inData[], uint16_t outData[], uint32_t inCount, uint16_t inMultiplier, uint8_t inScale, int8_t inSign)
+{
+    if (!inScale)
+    {
+        for (uint32_t dataIdx = 0; dataIdx < inCount; dataIdx ++)
+        {
+            outData[dataIdx] = 0;
+        }
+        return;
+    }
+
+    // Same result as ConversionDecode, loops are kept branch free so the compiler can vectorize them (-O3).
+    // Rounding up never goes past UINT16_MAX, so clamp and round up is min(result + roundup, UINT16_MAX).
+    const uint32_t roundupMask = 1 << (inScale - 1);
+    if (inSign < 0)
+    {
+        for (uint32_t dataIdx = 0; dataIdx < inCount; dataIdx ++)
+        {
+            uint32_t product = (uint32_t)inData[dataIdx] * inMultiplier;
+            uint32_t result = product >> inScale;
+            result = (result >= kConversionNegativeOffset) ? (result - kConversionNegativeOffset) : (kConversionNegativeOffset - result);
+            result += ((product & roundupMask) != 0);
+            outData[dataIdx] = (result > UINT16_MAX) ? UINT16_MAX : result;
+        }
+    }
+    else
+    {
+        for (uint32_t dataIdx = 0; dataIdx < inCount; dataIdx ++)
+        {
+            uint32_t product = (uint32_t)inData[dataIdx] * inMultiplier;
+            uint32_t result = (product >> inScale) + ((product & roundupMask) != 0);
+            outData[dataIdx] = (result > UINT16_MAX) ? UINT16_MAX : result;
+        }
+    }
+}
+
 // --------------------------------------------------------------------------------------------------------------
 uint16_t ComputeAmplitude(uint16_t inDataTable[], uint16_t inSize, uint16_t* outMin, uint16_t* outMax)
 {
-    // Initialize min & max to opposites.
-    *outMax = 0;
-    *outMin = UINT16_MAX;
+    // Initialize min & max to opposites, accumulate in locals so the loop can be vectorized.
+    uint16_t minValue = UINT16_MAX;
+    uint16_t maxValue = 0;
 
-    for (int tableIdx = 0; tableIdx < inSize; tableIdx ++)
+    for (uint32_t tableIdx = 0; tableIdx < inSize; tableIdx ++)
     {
-        *outMin = min(*outMin, inDataTable[tableIdx]);
-        *outMax = max(*outMax, inDataTable[tableIdx]);
+        minValue = min(minValue, inDataTable[tableIdx]);
+        maxValue = max(maxValue, inDataTable[tableIdx]);
     }
 
+    *outMin = minValue;
+    *outMax = maxValue;
+
+    return maxValue - minValue;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+int ConversionAmplitudeWindowInit(ConversionAmplitudeWindow_t* outWindow, ConversionAmplitudeEntry_t inMinEntries[], ConversionAmplitudeEntry_t inMaxEntries[], uint16_t inWindowSize)
+{
+    outWindow->minEntries = inMinEntries;
+    outWindow->maxEntries = inMaxEntries;
+    outWindow->windowSize = inWindowSize;
+    outWindow->minHead = 0;
+    outWindow->minCount = 0;
+    outWindow->maxHead = 0;
+    outWindow->maxCount = 0;
+    outWindow->sequence = 0;
+
+    // No entry to hold the sample being pushed.
+    if (inWindowSize == 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+// Push on a monotonic deque, inKeep(back, new) tells if the back entry stays. Returns the front value.
+static uint16_t ConversionAmplitudeDequePush(ConversionAmplitudeEntry_t inEntries[], uint16_t* ioHead, uint16_t* ioCount, uint16_t inWindowSize, uint32_t inSequence, uint16_t inData, int inKeepGreater)
+{
+    // The front entry leaves the window (at most one per sample).
+    if (*ioCount && ((inSequence - inEntries[*ioHead].sequence) >= inWindowSize))
+    {
+        *ioHead = (*ioHead + 1 == inWindowSize) ? 0 : *ioHead + 1;
+        (*ioCount) --;
+    }
+
+    // Entries dominated by the new one can never be the min / max again.
+    while (*ioCount)
+    {
+        uint16_t backIdx = *ioHead + *ioCount - 1;
+        backIdx = (backIdx >= inWindowSize) ? backIdx - inWindowSize : backIdx;
+        uint16_t backValue = inEntries[backIdx].value;
+        if (inKeepGreater ? (backValue > inData) : (backValue < inData))
+        {
+            break;
+        }
+        (*ioCount) --;
+    }
+
+    uint16_t newIdx = *ioHead + *ioCount;
+    newIdx = (newIdx >= inWindowSize) ? newIdx - inWindowSize : newIdx;
+    inEntries[newIdx].sequence = inSequence;
+    inEntries[newIdx].value = inData;
+    (*ioCount) ++;
+
+    return inEntries[*ioHead].value;
+}
+
+// --------------------------------------------------------------------------------------------------------------
+uint16_t ConversionAmplitudeWindowPush(ConversionAmplitudeWindow_t* inWindow, uint16_t inData, uint16_t* outMin, uint16_t* outMax)
+{
+    // Rejected by ConversionAmplitudeWindowInit, the deque indexes wrap on the window size.
+    if (inWindow->windowSize == 0)
+    {
+        *outMin = inData;
+        *outMax = inData;
+        return 0;
+    }
+
+    uint32_t sequence = inWindow->sequence ++;
+
+    *outMax = ConversionAmplitudeDequePush(inWindow->maxEntries, &inWindow->maxHead, &inWindow->maxCount, inWindow->windowSize, sequence, inData, 1);
+    *outMin = ConversionAmplitudeDequePush(inWindow->minEntries, &inWindow->minHead, &inWindow->minCount, inWindow->windowSize, sequence, inData, 0);
+
     return *outMax - *outMin;
 }
@@ -37,13 +37,68 @@ typedef struct
     int8_t sign;
 } ConversionEncode_t;
 
+// Channel calibration, value = ConversionDecode(data, encode) * (1 + gainTrim / 2^15) + offset.
+typedef struct
+{
+    ConversionEncode_t encode;
+    // Output units.
+    int16_t offset;
+    // Q15 gain correction, 0 for none.
+    int16_t gainTrim;
+} ConversionCalibration_t;
+
+// Calibration fused by ConversionFuse, decoded with a single multiply and shift.
+typedef struct
+{
+    uint16_t multiplier;
+    uint8_t scale;
+    int8_t sign;
+    int16_t offset;
+} ConversionFused_t;
+
+typedef struct
+{
+    uint32_t sequence;
+    uint16_t value;
+} ConversionAmplitudeEntry_t;
+
+// Sliding window min / max (monotonic deques), entries are provided by the caller.
+typedef struct
+{
+    ConversionAmplitudeEntry_t* minEntries;
+    ConversionAmplitudeEntry_t* maxEntries;
+    uint16_t windowSize;
+    uint16_t minHead;
+    uint16_t minCount;
+    uint16_t maxHead;
+    uint16_t maxCount;
+    uint32_t sequence;
+} ConversionAmplitudeWindow_t;
+
 // --------------------------------------------------------------------------------------------------------------
 // Function prototypes
 // --------------------------------------------------------------------------------------------------------------
 ///
 uint16_t ConversionDecode(uint16_t inData, uint16_t inMultiplier, uint8_t inScale, int8_t inSign);
+/// Inverse of ConversionDecode for thresholds: outData is the largest input decoded to at most inValue, so
+/// ConversionDecode(x) > inValue if and only if x > outData. Returns -1 if not monotonic (inSign < 0).
+int ConversionEncode(uint16_t inValue, uint16_t inMultiplier, uint8_t inScale, int8_t inSign, uint16_t* outData);
+/// Fold the gain trim into the multiplier and scale, returns -1 if out of range. Without trim and offset and with a
+/// multiplier below 2^15, ConversionDecodeFused gives the same results as ConversionDecode.
+int ConversionFuse(const ConversionCalibration_t* inCalibration, ConversionFused_t* outFused);
+/// Calibrated value of inData, clamped to [0, UINT16_MAX].
+uint16_t ConversionDecodeFused(uint16_t inData, const ConversionFused_t* inFused);
+/// ConversionEncode for a fused calibration, returns -1 if not monotonic or if inValue is below the value of 0.
+int ConversionEncodeFused(uint16_t inValue, const ConversionFused_t* inFused, uint16_t* outData);
+/// ConversionDecode on inCount samples.
+void ConversionDecodeBatch(const uint16_t inData[], uint16_t outData[], uint32_t inCount, uint16_t inMultiplier, uint8_t inScale, int8_t inSign);
 ///
 uint16_t ComputeAmplitude(uint16_t inDataTable[], uint16_t inSize, uint16_t* outMin, uint16_t* outMax);
+/// Sliding window amplitude over the last inWindowSize samples, inMinEntries and inMaxEntries hold inWindowSize entries each.
+/// Returns -1 if inWindowSize is 0, ConversionAmplitudeWindowPush then returns 0 without storing the samples.
+int ConversionAmplitudeWindowInit(ConversionAmplitudeWindow_t* outWindow, ConversionAmplitudeEntry_t inMinEntries[], ConversionAmplitudeEntry_t inMaxEntries[], uint16_t inWindowSize);
+/// Add a sample and return the amplitude of the window (amortized O(1)).
+uint16_t ConversionAmplitudeWindowPush(ConversionAmplitudeWindow_t* inWindow, uint16_t inData, uint16_t* outMin, uint16_t* outMax);
 
 #ifdef __cplusplus
 }
@@ -18,30 +18,136 @@
 
 // Standard includes.
 #include <stdbool.h>
+#include <stddef.h>
 
 // Lib includes.
 #include "iomodutils.h"
+#include "iomodbus.h"
 
 // Driver includes.
 #include "adc128d818.h"
 
-// Bus includes.
-#include "i2c.h"
-
 // ----------------------------------------------------------------------------
 // Private variables.
-static ADC128D818_t gADC128D818[kADC128D818_MaxAddresses];
+static ADC128D818_t gADC128D818[kIOModBusMax][kADC128D818_MaxAddresses];
 
 // Private constants.
 #define kADCBusyTimeout 0x0010
 
+// Register of each cache entry (ADC128D818_Cache_t).
+static const uint8_t kADC128D818CacheRegisters[kADC128D818_Cache_Max] =
+{
+    kADC128D818_RegisterConfiguration,
+    kADC128D818_RegisterInterruptMask,
+    kADC128D818_RegisterConversionRate,
+    kADC128D818_RegisterChannelDisable,
+    kADC128D818_RegisterDeepShutdown,
+    kADC128D818_RegisterAdvancedConfiguration,
+};
+
+// ----------------------------------------------------------------------------
+static ADC128D818_t* ADC128D818GetDevice(uint16_t inADCDevice)
+{
+    uint8_t busID = mIOModBusDeviceBus(inADCDevice);
+    uint8_t address = mIOModBusDeviceAddress(inADCDevice);
+    uint8_t addressIdx;
+
+    // Addresses come in 3 groups of 3.
+    if ((address >= kADC128D818_SlaveAddress1) && (address <= kADC128D818_SlaveAddress3))
+    {
+        addressIdx = address - kADC128D818_SlaveAddress1;
+    }
+    else if ((address >= kADC128D818_SlaveAddress4) && (address <= kADC128D818_SlaveAddress6))
+    {
+        addressIdx = 3 + address - kADC128D818_SlaveAddress4;
+    }
+    else if ((address >= kADC128D818_SlaveAddress7) && (address <= kADC128D818_SlaveAddress9))
+    {
+        addressIdx = 6 + address - kADC128D818_SlaveAddress7;
+    }
+    else
+    {
+        return NULL;
+    }
+
+    if (busID >= kIOModBusMax)
+    {
+        return NULL;
+    }
+
+    return &gADC128D818[busID][addressIdx];
+}
+
+// ----------------------------------------------------------------------------
+// Write a cached register, skipped when the device already holds inValue.
+static int ADC128D818WriteCached(uint16_t inADCDevice, uint8_t inCacheIdx, uint8_t inValue)
+{
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+
+    if ((adc != NULL) && (adc->cacheValidMask & (1 << inCacheIdx)) && (adc->cache[inCacheIdx] == inValue))
+    {
+        return 0;
+    }
+
+    int status = IOModBusWriteRegister(inADCDevice, kADC128D818CacheRegisters[inCacheIdx], &inValue, 1);
+    if (adc == NULL)
+    {
+        return status;
+    }
+
+    if ((inCacheIdx == kADC128D818_Cache_Configuration) && (inValue & kADC128D818_RegisterConfiguration_Init))
+    {
+        // Registers are back to their defaults, the bit clears itself.
+        adc->cacheValidMask = 0;
+    }
+    else if (status == 0)
+    {
+        adc->cache[inCacheIdx] = inValue;
+        adc->cacheValidMask |= (1 << inCacheIdx);
+    }
+    else
+    {
+        // The write may or may not have reached the device.
+        adc->cacheValidMask &= ~(1 << inCacheIdx);
+    }
+
+    return status;
+}
+
 // ----------------------------------------------------------------------------
-static bool ADC128D818IsBusy(uint8_t inADCAddress, uint8_t inBusyFlag)
+// Read-modify-write of the configuration register, read from the cache when valid.
+static int ADC128D818UpdateConfiguration(uint16_t inADCDevice, uint8_t inClearBits, uint8_t inSetBits)
+{
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+    uint8_t i2cData = 0;
+
+    if ((adc != NULL) && (adc->cacheValidMask & (1 << kADC128D818_Cache_Configuration)))
+    {
+        i2cData = adc->cache[kADC128D818_Cache_Configuration];
+    }
+    else
+    {
+        int status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterConfiguration, &i2cData, 1);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+
+    // INT_Clear stops the round robin, only set explicitly.
+    i2cData &= ~(inClearBits | kADC128D818_RegisterConfiguration_INT_Clear | kADC128D818_RegisterConfiguration_Init);
+    i2cData |= inSetBits;
+
+    return ADC128D818WriteCached(inADCDevice, kADC128D818_Cache_Configuration, i2cData);
+}
+
+// ----------------------------------------------------------------------------
+static bool ADC128D818IsBusy(uint16_t inADCDevice, uint8_t inBusyFlag)
 {
     bool isBusy = true;
     uint8_t i2cData = 0;
 
-    int status = I2CReadRegister(inADCAddress, kADC128D818_RegisterBusyStatus, &i2cData, 1);
+    int status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterBusyStatus, &i2cData, 1);
     if (status != 0)
     {
         return true;
@@ -65,7 +171,7 @@ static bool ADC128D818IsBusy(uint8_t inADCAddress, uint8_t inBusyFlag)
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818Init(uint8_t inADCAddress)
+int ADC128D818Init(uint16_t inADCDevice)
 {
     // TODO: Power on the device, then wait for at least 33ms.
     /*7. Program the Limit Registers (addresses 2Ah � 39h).
@@ -78,7 +184,7 @@ int ADC128D818Init(uint8_t inADCAddress)
 
     // Verify if the ADC is busy.
     uint32_t timeout = kADCBusyTimeout;
-    while (ADC128D818IsBusy(inADCAddress, kADC128D818_RegisterBusyStatus_NotReady))
+    while (ADC128D818IsBusy(inADCDevice, kADC128D818_RegisterBusyStatus_NotReady))
     {
         if ((-- timeout) == 0)
         {
@@ -86,15 +192,24 @@ int ADC128D818Init(uint8_t inADCAddress)
         }
     }
 
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+    if (adc == NULL)
+    {
+        return -1;
+    }
+
+    // The device may have been power cycled, write the whole configuration.
+    adc->cacheValidMask = 0;
+
     // Read manufacturing data.
-    int status = I2CReadRegister(inADCAddress, kADC128D818_RegisterManufacturerID, &(gADC128D818[0].manufacturerID), 1);
+    int status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterManufacturerID, &(adc->manufacturerID), 1);
     if (status != 0)
     {
         return status;
     }
 
     // Read revision data.
-    status = I2CReadRegister(inADCAddress, kADC128D818_RegisterRevisionID, &(gADC128D818[0].revisionID), 1);
+    status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterRevisionID, &(adc->revisionID), 1);
     if (status != 0)
     {
         return status;
@@ -102,23 +217,25 @@ int ADC128D818Init(uint8_t inADCAddress)
 
     const uint8_t gADC128D818RegisterConfigTable[] =
     {
+        // Shutdown (the conversion rate is only programmed with START = 0), INT disabled.
+        kADC128D818_Cache_Configuration, 0,
         // Set ADC operation mode and VREF.
-        kADC128D818_RegisterAdvancedConfiguration, (kADC128D818_Mode_SingleEnded << 1) | kADC128D818_RegisterAdvancedConfiguration_ExternalReferenceEnable,
+        kADC128D818_Cache_AdvancedConfiguration, (kADC128D818_Mode_SingleEnded << 1) | kADC128D818_RegisterAdvancedConfiguration_ExternalReferenceEnable,
         // Set Conversion Rate.
-        kADC128D818_RegisterConversionRate, kADC128D818_ConversionRate_Continuous,
+        kADC128D818_Cache_ConversionRate, kADC128D818_ConversionRate_Continuous,
         // Enable channels.
-        kADC128D818_RegisterChannelDisable, kADC128D818_RegisterChannelDisable_None,
+        kADC128D818_Cache_ChannelDisable, kADC128D818_RegisterChannelDisable_None,
         // Disable interrupts.
-        kADC128D818_RegisterInterruptMask, kADC128D818_RegisterInterruptMask_All,
+        kADC128D818_Cache_InterruptMask, kADC128D818_RegisterInterruptMask_All,
     };
 
     // Configure ADC with predefined registers.
     int adcRegisterTableSize = sizeof(gADC128D818RegisterConfigTable) / sizeof(uint8_t);
     for (uint8_t registerIdx = 0; registerIdx < adcRegisterTableSize; registerIdx ++)
     {
-        uint8_t registerAddress = gADC128D818RegisterConfigTable[registerIdx ++];
+        uint8_t cacheIdx = gADC128D818RegisterConfigTable[registerIdx ++];
         uint8_t registerValue = gADC128D818RegisterConfigTable[registerIdx];
-        status = I2CWriteRegister(inADCAddress, registerAddress, &registerValue, 1);
+        status = ADC128D818WriteCached(inADCDevice, cacheIdx, registerValue);
         if (status != 0)
         {
             break;
@@ -129,81 +246,280 @@ int ADC128D818Init(uint8_t inADCAddress)
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818SetMode(uint8_t inADCAddress, uint8_t inMode)
+int ADC128D818SetMode(uint16_t inADCDevice, uint8_t inMode)
 {
     mIOAssertArg(mADC128D818IsMode(inMode));
 
     uint8_t i2cData = (inMode << 1) | kADC128D818_RegisterAdvancedConfiguration_ExternalReferenceEnable;
 
-    int status = I2CWriteRegister(inADCAddress, kADC128D818_RegisterAdvancedConfiguration, &i2cData, 1);
+    int status = ADC128D818WriteCached(inADCDevice, kADC128D818_Cache_AdvancedConfiguration, i2cData);
 
     return status;
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818StartConversion(uint8_t inADCAddress, uint8_t inMode)
+int ADC128D818GetMode(uint16_t inADCDevice, uint8_t* outMode)
+{
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+    uint8_t i2cData = 0;
+    int status = 0;
+
+    if ((adc != NULL) && (adc->cacheValidMask & (1 << kADC128D818_Cache_AdvancedConfiguration)))
+    {
+        i2cData = adc->cache[kADC128D818_Cache_AdvancedConfiguration];
+    }
+    else
+    {
+        status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterAdvancedConfiguration, &i2cData, 1);
+        if ((adc != NULL) && (status == 0))
+        {
+            adc->cache[kADC128D818_Cache_AdvancedConfiguration] = i2cData;
+            adc->cacheValidMask |= (1 << kADC128D818_Cache_AdvancedConfiguration);
+        }
+    }
+
+    *outMode = (i2cData & (kADC128D818_RegisterAdvancedConfiguration_ModeSelect0 | kADC128D818_RegisterAdvancedConfiguration_ModeSelect1)) >> 1;
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818StartConversion(uint16_t inADCDevice, uint8_t inMode)
 {
     mIOAssertArg(mADC128D818IsConversionRate(inMode));
 
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+    int status = 0;
+
+    // The conversion rate is only programmed with START = 0.
+    if ((adc == NULL) || !(adc->cacheValidMask & (1 << kADC128D818_Cache_ConversionRate)) || (adc->cache[kADC128D818_Cache_ConversionRate] != inMode))
+    {
+        status |= ADC128D818StopConversion(inADCDevice);
+    }
+
     // Select conversion mode.
-    uint8_t i2cData = inMode;
-    int status = I2CWriteRegister(inADCAddress, kADC128D818_RegisterConversionRate, &i2cData, 1);
+    status |= ADC128D818WriteCached(inADCDevice, kADC128D818_Cache_ConversionRate, inMode);
 
     // Enable startup of monitoring operations.
     // A voltage conversion takes 12.2 ms and a temperature conversion takes 3.6 ms
-    i2cData = kADC128D818_RegisterConfiguration_Start;
-    status |= I2CWriteRegister(inADCAddress, kADC128D818_RegisterConfiguration, &i2cData, 1);
+    status |= ADC128D818UpdateConfiguration(inADCDevice, 0, kADC128D818_RegisterConfiguration_Start);
 
     return status;
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818StopConversion(uint8_t inADCAddress)
+int ADC128D818StopConversion(uint16_t inADCDevice)
 {
-    // Disable monitoring operations.
-    uint8_t i2cData = 0;
-
-    int status = I2CWriteRegister(inADCAddress, kADC128D818_RegisterConfiguration, &i2cData, 1);
+    // Disable monitoring operations, INT_Enable is kept.
+    int status = ADC128D818UpdateConfiguration(inADCDevice, kADC128D818_RegisterConfiguration_Start, 0);
 
     return status;
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818SingleConversion(uint8_t inADCAddress)
+int ADC128D818SingleConversion(uint16_t inADCDevice)
 {
     uint8_t i2cData = kADC128D818_RegisterOneShot_OneShot;
 
-    int status = I2CWriteRegister(inADCAddress, kADC128D818_RegisterOneShot, &i2cData, 1);
+    int status = IOModBusWriteRegister(inADCDevice, kADC128D818_RegisterOneShot, &i2cData, 1);
 
     return status;
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818DeepShutdown(uint8_t inADCAddress, uint8_t inShutdownMode)
+int ADC128D818ReadBusyStatus(uint16_t inADCDevice, uint8_t* outStatus)
+{
+    *outStatus = 0;
+
+    int status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterBusyStatus, outStatus, 1);
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818DeepShutdown(uint16_t inADCDevice, uint8_t inShutdownMode)
 {
     mIOAssertArg(mADC128D818IsDeepShutdown(inShutdownMode));
 
-    int status = I2CWriteRegister(inADCAddress, kADC128D818_RegisterDeepShutdown, &inShutdownMode, 1);
+    int status = ADC128D818WriteCached(inADCDevice, kADC128D818_Cache_DeepShutdown, inShutdownMode);
 
     return status;
 }
 
 // ----------------------------------------------------------------------------
-int ADC128D818ReadChannel(uint8_t inADCAddress, uint8_t inChannel, uint16_t* outADCData)
+int ADC128D818ReadChannel(uint16_t inADCDevice, uint8_t inChannel, uint16_t* outADCData)
 {
     // Add channel address base.
     inChannel |= kADC128D818_RegisterChannel0Read;
 
     mIOAssertArg(mADC128D818IsChannelReadings(inChannel));
 
-    uint8_t i2cData = 0;
-    uint8_t* i2cDataPointer = &i2cData;
-    int status = I2CReadRegister(inADCAddress, inChannel, i2cDataPointer, 2);
+    uint8_t i2cData[2] = { 0 };
+    int status = IOModBusReadRegister(inADCDevice, inChannel, i2cData, 2);
+
+    *outADCData = ADC128D818DecodeReading(i2cData);
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818ReadAllChannels(uint16_t inADCDevice, uint8_t inChannelMask, uint16_t outADCData[kADC128D818_MaxChannels])
+{
+    uint8_t i2cData[kADC128D818_MaxChannels][2];
+    int status = 0;
+
+    // The register pointer does not auto-increment over the 16-bit channel readings registers, the minimum is one
+    // read per channel. Skip the channels not in the mask.
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if (inChannelMask & (1 << channelIdx))
+        {
+            status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterChannel0Read + channelIdx, i2cData[channelIdx], 2);
+            if (status != 0)
+            {
+                return status;
+            }
+        }
+    }
+
+    // Decode all readings in one pass.
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if (inChannelMask & (1 << channelIdx))
+        {
+            outADCData[channelIdx] = ADC128D818DecodeReading(i2cData[channelIdx]);
+        }
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818SetChannelMask(uint16_t inADCDevice, uint8_t inChannelMask)
+{
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+    uint8_t channelDisable = (uint8_t)~inChannelMask;
+    uint8_t configuration = 0;
+    int status;
+
+    if ((adc != NULL) && (adc->cacheValidMask & (1 << kADC128D818_Cache_ChannelDisable)) && (adc->cache[kADC128D818_Cache_ChannelDisable] == channelDisable))
+    {
+        return 0;
+    }
+
+    if ((adc != NULL) && (adc->cacheValidMask & (1 << kADC128D818_Cache_Configuration)))
+    {
+        configuration = adc->cache[kADC128D818_Cache_Configuration];
+    }
+    else
+    {
+        status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterConfiguration, &configuration, 1);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+
+    // The round robin restarts with the new set of channels.
+    if (configuration & kADC128D818_RegisterConfiguration_Start)
+    {
+        status = ADC128D818UpdateConfiguration(inADCDevice, kADC128D818_RegisterConfiguration_Start, 0);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
 
-    uint16_t adcDataBuffer = *(uint16_t*)(i2cDataPointer);
+    status = ADC128D818WriteCached(inADCDevice, kADC128D818_Cache_ChannelDisable, channelDisable);
 
-    // ADC returns LSByte first [16..4]. Convert to MSByte first with result [12..0]
-    *outADCData = mHTONS(adcDataBuffer) >> 4;
+    if (configuration & kADC128D818_RegisterConfiguration_Start)
+    {
+        status |= ADC128D818UpdateConfiguration(inADCDevice, 0, kADC128D818_RegisterConfiguration_Start);
+    }
 
     return status;
 }
+
+// ----------------------------------------------------------------------------
+int ADC128D818SetLimits(uint16_t inADCDevice, uint8_t inChannel, uint16_t inLowLimit, uint16_t inHighLimit)
+{
+    mIOAssertArg(inChannel < kADC128D818_MaxChannels);
+
+    uint8_t i2cData = (uint8_t)(inHighLimit >> kADC128D818_LimitShift);
+    int status = IOModBusWriteRegister(inADCDevice, mADC128D818RegisterLimitHigh(inChannel), &i2cData, 1);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    i2cData = (uint8_t)(inLowLimit >> kADC128D818_LimitShift);
+    status = IOModBusWriteRegister(inADCDevice, mADC128D818RegisterLimitLow(inChannel), &i2cData, 1);
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818EnableInterrupts(uint16_t inADCDevice, uint8_t inChannelMask)
+{
+    // Mask bits are set for the channels not propagating to INT.
+    int status = ADC128D818WriteCached(inADCDevice, kADC128D818_Cache_InterruptMask, (uint8_t)~inChannelMask);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    if (inChannelMask != 0)
+    {
+        status = ADC128D818UpdateConfiguration(inADCDevice, 0, kADC128D818_RegisterConfiguration_INT_Enable);
+    }
+    else
+    {
+        status = ADC128D818UpdateConfiguration(inADCDevice, kADC128D818_RegisterConfiguration_INT_Enable, 0);
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818ReadInterruptStatus(uint16_t inADCDevice, uint8_t* outStatus)
+{
+    *outStatus = 0;
+
+    int status = IOModBusReadRegister(inADCDevice, kADC128D818_RegisterInterruptStatus, outStatus, 1);
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818InvalidateCache(uint16_t inADCDevice)
+{
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+
+    if (adc != NULL)
+    {
+        adc->cacheValidMask = 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818SyncCache(uint16_t inADCDevice)
+{
+    ADC128D818_t* adc = ADC128D818GetDevice(inADCDevice);
+    if (adc == NULL)
+    {
+        return -1;
+    }
+
+    adc->cacheValidMask = 0;
+    for (uint8_t cacheIdx = 0; cacheIdx < kADC128D818_Cache_Max; cacheIdx ++)
+    {
+        int status = IOModBusReadRegister(inADCDevice, kADC128D818CacheRegisters[cacheIdx], &(adc->cache[cacheIdx]), 1);
+        if (status != 0)
+        {
+            return status;
+        }
+        adc->cacheValidMask |= (1 << cacheIdx);
+    }
+
+    return 0;
+}
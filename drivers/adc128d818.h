@@ -199,12 +199,36 @@ typedef enum
 #define kADC128D818_RegisterChannel7LimitHigh 0x38
 #define kADC128D818_RegisterChannel7LimitLow 0x39
 
+// Voltage limits are compared with the 8 MSBs of the 12-bit readings.
+#define kADC128D818_LimitShift 4
+
 // Manufacturer ID register. Reports the manufacturer's ID, R, 8-bit.
 #define kADC128D818_RegisterManufacturerID 0x3E
+#define kADC128D818_ManufacturerID 0x01
 
 // Revision ID register. Reports the revision's ID, R, 8-bit.
 #define kADC128D818_RegisterRevisionID 0x3F
 
+// Conversion times (continuous conversion rate), a round robin converts each enabled channel once.
+#define kADC128D818_VoltageConversionUs 12200
+#define kADC128D818_TemperatureConversionUs 3600
+// Low power conversion rate: a round robin, then shutdown until the next one.
+#define kADC128D818_LowPowerCycleUs 728000
+// Power-up sequence (Not Ready).
+#define kADC128D818_PowerUpUs 33000
+
+// Registers kept in the driver cache, writes of an unchanged value are skipped.
+typedef enum
+{
+    kADC128D818_Cache_Configuration,
+    kADC128D818_Cache_InterruptMask,
+    kADC128D818_Cache_ConversionRate,
+    kADC128D818_Cache_ChannelDisable,
+    kADC128D818_Cache_DeepShutdown,
+    kADC128D818_Cache_AdvancedConfiguration,
+    kADC128D818_Cache_Max,
+} ADC128D818_Cache_t;
+
 // ----------------------------------------------------------------------------
 // Macros
 // ----------------------------------------------------------------------------
@@ -214,6 +238,10 @@ typedef enum
 #define mADC128D818IsChannelReadings(channel) ((channel == kADC128D818_RegisterChannel0Read) || (channel == kADC128D818_RegisterChannel1Read) || (channel == kADC128D818_RegisterChannel2Read) || (channel == kADC128D818_RegisterChannel3Read) || (channel == kADC128D818_RegisterChannel4Read) || (channel == kADC128D818_RegisterChannel5Read) || (channel == kADC128D818_RegisterChannel6Read) || (channel == kADC128D818_RegisterChannel7Read))
 #define mADC128D818IsConversionRate(mode) ((mode == kADC128D818_ConversionRate_Continuous) || (mode == kADC128D818_ConversionRate_LowPower))
 
+// Limit registers of a channel.
+#define mADC128D818RegisterLimitHigh(channel) (kADC128D818_RegisterChannel0LimitHigh + ((channel) << 1))
+#define mADC128D818RegisterLimitLow(channel) (kADC128D818_RegisterChannel0LimitLow + ((channel) << 1))
+
 // ----------------------------------------------------------------------------
 // Data types
 // ----------------------------------------------------------------------------
@@ -229,25 +257,79 @@ typedef struct
     uint16_t channel5data;
     uint16_t channel6data;
     uint16_t channel7data;
+    // Register cache (ADC128D818_Cache_t), bit n of cacheValidMask is set when cache[n] matches the device.
+    uint8_t cache[kADC128D818_Cache_Max];
+    uint8_t cacheValidMask;
 } ADC128D818_t;
 
+// ----------------------------------------------------------------------------
+// Inline functions
+// ----------------------------------------------------------------------------
+/// Decode a channel reading register, for readings done without ADC128D818ReadChannel (ex: asynchronous transfers).
+static inline uint16_t ADC128D818DecodeReading(const uint8_t inI2CData[2])
+{
+    // ADC returns the 12-bit result MSByte first on bits [15..4]. Convert to result [11..0].
+    return (uint16_t)(((inI2CData[0] << 8) | inI2CData[1]) >> 4);
+}
+
+/// Duration of a continuous round robin over the channels of inChannelMask (bit n = INn) in mode inMode
+/// (ADC128D818_Mode_t), each channel has a new reading at least once per round robin. Estimate for modes 0 and 1.
+static inline uint32_t ADC128D818CycleUs(uint8_t inChannelMask, uint8_t inMode)
+{
+    uint32_t cycleUs = 0;
+
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if (inChannelMask & (1 << channelIdx))
+        {
+            // In mode 0, IN7 reads the internal temperature.
+            cycleUs += ((channelIdx == kADC128D818_IN7) && (inMode == kADC128D818_Mode_Temp)) ? kADC128D818_TemperatureConversionUs : kADC128D818_VoltageConversionUs;
+        }
+    }
+
+    return cycleUs;
+}
+
 // ----------------------------------------------------------------------------
 // Function prototypes
 // ----------------------------------------------------------------------------
+// inADCDevice is mIOModBusDevice(bus, address) (see iomodbus.h), the plain address for bus 0.
 ///
-int ADC128D818Init(uint8_t inADCAddress);
-///
-int ADC128D818SetMode(uint8_t inADCAddress, uint8_t inMode);
-///
-int ADC128D818StartConversion(uint8_t inADCAddress, uint8_t inMode);
+int ADC128D818Init(uint16_t inADCDevice);
 ///
-int ADC128D818StopConversion(uint8_t inADCAddress);
+int ADC128D818SetMode(uint16_t inADCDevice, uint8_t inMode);
+/// Read the current mode (ADC128D818_Mode_t), from the register cache when valid.
+int ADC128D818GetMode(uint16_t inADCDevice, uint8_t* outMode);
+/// Start the round robin at conversion rate inMode (ADC128D818_ConversionRate_t), conversions are stopped first when
+/// the rate changes.
+int ADC128D818StartConversion(uint16_t inADCDevice, uint8_t inMode);
 ///
-int ADC128D818SingleConversion(uint8_t inADCAddress);
+int ADC128D818StopConversion(uint16_t inADCDevice);
+/// One round robin of the enabled channels from shutdown or deep shutdown, then back to it.
+int ADC128D818SingleConversion(uint16_t inADCDevice);
+/// Read the busy status (ADC128D818_RegisterBusyStatus_t), Busy is set until a one-shot round robin is done.
+int ADC128D818ReadBusyStatus(uint16_t inADCDevice, uint8_t* outStatus);
 ///
-int ADC128D818DeepShutdown(uint8_t inADCAddress, uint8_t inShutdownMode);
+int ADC128D818DeepShutdown(uint16_t inADCDevice, uint8_t inShutdownMode);
 ///
-int ADC128D818ReadChannel(uint8_t inADCAddress, uint8_t inChannel, uint16_t* outADCData);
+int ADC128D818ReadChannel(uint16_t inADCDevice, uint8_t inChannel, uint16_t* outADCData);
+/// Read the channels set in inChannelMask (bit n = INn) into outADCData[n], other entries are left untouched.
+int ADC128D818ReadAllChannels(uint16_t inADCDevice, uint8_t inChannelMask, uint16_t outADCData[kADC128D818_MaxChannels]);
+/// Convert only the channels in inChannelMask (bit n = INn), readings of the others are 0. Conversions are stopped
+/// around the update if running.
+int ADC128D818SetChannelMask(uint16_t inADCDevice, uint8_t inChannelMask);
+/// Program the limits of a channel from 12-bit readings (16 counts resolution). A reading above inHighLimit or below
+/// inLowLimit sets the channel bit of the interrupt status. In temperature mode, IN7 limits are the hot / hot hysteresis
+/// limits, 8-bit two's complement degrees C.
+int ADC128D818SetLimits(uint16_t inADCDevice, uint8_t inChannel, uint16_t inLowLimit, uint16_t inHighLimit);
+/// Let limit events of the channels in inChannelMask (bit n = INn) assert INT, INT is disabled if the mask is 0.
+int ADC128D818EnableInterrupts(uint16_t inADCDevice, uint8_t inChannelMask);
+/// Read the interrupt status (bit n = INn out of limits). Reading clears the status, INT is released.
+int ADC128D818ReadInterruptStatus(uint16_t inADCDevice, uint8_t* outStatus);
+/// Forget the cached registers (ex: after a power cycle of the device), the next writes always reach the device.
+void ADC128D818InvalidateCache(uint16_t inADCDevice);
+/// Read back the cached registers from the device.
+int ADC128D818SyncCache(uint16_t inADCDevice);
 
 #ifdef __cplusplus
 }
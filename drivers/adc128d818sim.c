@@ -0,0 +1,609 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+// Standard includes.
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// Lib includes.
+#include "iomodbus.h"
+
+// Driver includes.
+#include "adc128d818.h"
+#include "adc128d818sim.h"
+
+// ----------------------------------------------------------------------------
+// Private constants.
+#define kADC128D818SimMaxDevices (kIOModBusMax * kADC128D818_MaxAddresses)
+#define kADC128D818SimRegisterCount 0x40
+#define kADC128D818SimRevisionID 0x09
+// Bits per transferred byte, acknowledge included.
+#define kADC128D818SimBitsPerByte 9
+
+// ----------------------------------------------------------------------------
+// Private types.
+typedef struct
+{
+    bool used;
+    uint16_t device;
+    uint8_t registers[kADC128D818SimRegisterCount];
+    // Channel readings registers.
+    uint16_t readings[kADC128D818_MaxChannels];
+    uint64_t readingsUs[kADC128D818_MaxChannels];
+    uint8_t readingsReadMask;
+    uint16_t inputs[kADC128D818_MaxChannels];
+    int32_t temperature;
+    // Round robin.
+    bool converting;
+    bool oneShot;
+    uint8_t channel;
+    uint64_t conversionEndUs;
+    uint64_t cycleStartUs;
+    uint64_t nextCycleUs;
+    uint64_t readyUs;
+    uint32_t conversionCount;
+} ADC128D818SimDevice_t;
+
+// Private variables.
+static ADC128D818SimDevice_t gSimDevices[kADC128D818SimMaxDevices];
+static uint64_t gSimTimeUs;
+static uint32_t gSimBusSpeed[kIOModBusMax];
+static bool gSimBusSpeedSet[kIOModBusMax];
+static ADC128D818SimBusStats_t gSimBusStats[kIOModBusMax];
+
+// ----------------------------------------------------------------------------
+static ADC128D818SimDevice_t* ADC128D818SimGetDevice(uint16_t inADCDevice)
+{
+    for (uint8_t deviceIdx = 0; deviceIdx < kADC128D818SimMaxDevices; deviceIdx ++)
+    {
+        if (gSimDevices[deviceIdx].used && (gSimDevices[deviceIdx].device == inADCDevice))
+        {
+            return &gSimDevices[deviceIdx];
+        }
+    }
+
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Power-on values.
+static void ADC128D818SimRestoreDefaults(ADC128D818SimDevice_t* inDevice)
+{
+    memset(inDevice->registers, 0, sizeof(inDevice->registers));
+    inDevice->registers[kADC128D818_RegisterConfiguration] = kADC128D818_RegisterConfiguration_INT_Clear;
+    // Limits out of reach: no limit event until programmed.
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        inDevice->registers[mADC128D818RegisterLimitHigh(channelIdx)] = 0xFF;
+        inDevice->registers[mADC128D818RegisterLimitLow(channelIdx)] = 0x00;
+    }
+    inDevice->registers[kADC128D818_RegisterManufacturerID] = kADC128D818_ManufacturerID;
+    inDevice->registers[kADC128D818_RegisterRevisionID] = kADC128D818SimRevisionID;
+
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        inDevice->readings[channelIdx] = 0;
+        inDevice->readingsUs[channelIdx] = gSimTimeUs;
+    }
+    inDevice->readingsReadMask = 0;
+    inDevice->converting = false;
+    inDevice->oneShot = false;
+}
+
+// ----------------------------------------------------------------------------
+static uint8_t ADC128D818SimGetMode(ADC128D818SimDevice_t* inDevice)
+{
+    return (inDevice->registers[kADC128D818_RegisterAdvancedConfiguration] & (kADC128D818_RegisterAdvancedConfiguration_ModeSelect0 | kADC128D818_RegisterAdvancedConfiguration_ModeSelect1)) >> 1;
+}
+
+// ----------------------------------------------------------------------------
+static bool ADC128D818SimIsTemperatureChannel(ADC128D818SimDevice_t* inDevice, uint8_t inChannel)
+{
+    return (inChannel == kADC128D818_IN7) && (ADC128D818SimGetMode(inDevice) == kADC128D818_Mode_Temp);
+}
+
+// ----------------------------------------------------------------------------
+static uint32_t ADC128D818SimConversionUs(ADC128D818SimDevice_t* inDevice, uint8_t inChannel)
+{
+    return ADC128D818SimIsTemperatureChannel(inDevice, inChannel) ? kADC128D818_TemperatureConversionUs : kADC128D818_VoltageConversionUs;
+}
+
+// ----------------------------------------------------------------------------
+// First enabled channel from inChannel, kADC128D818_MaxChannels if none.
+static uint8_t ADC128D818SimNextChannel(ADC128D818SimDevice_t* inDevice, uint8_t inChannel)
+{
+    while ((inChannel < kADC128D818_MaxChannels) && (inDevice->registers[kADC128D818_RegisterChannelDisable] & (1 << inChannel)))
+    {
+        inChannel ++;
+    }
+
+    return inChannel;
+}
+
+// ----------------------------------------------------------------------------
+static bool ADC128D818SimIsRunning(ADC128D818SimDevice_t* inDevice)
+{
+    uint8_t configuration = inDevice->registers[kADC128D818_RegisterConfiguration];
+
+    // INT_Clear stops the round robin.
+    return inDevice->oneShot || ((configuration & kADC128D818_RegisterConfiguration_Start) && !(configuration & kADC128D818_RegisterConfiguration_INT_Clear));
+}
+
+// ----------------------------------------------------------------------------
+static void ADC128D818SimConvert(ADC128D818SimDevice_t* inDevice, uint8_t inChannel)
+{
+    uint8_t* registers = inDevice->registers;
+
+    if (ADC128D818SimIsTemperatureChannel(inDevice, inChannel))
+    {
+        // 9-bit two's complement, 0.5 C per LSB, on bits [15..7].
+        int32_t temperature = (inDevice->temperature >= 0) ? (inDevice->temperature + 250) / 500 : -((-inDevice->temperature + 250) / 500);
+        inDevice->readings[inChannel] = (uint16_t)((temperature & 0x01FF) << 7);
+        // Hot limit, 8-bit two's complement degrees C.
+        if ((temperature >> 1) > (int8_t)registers[mADC128D818RegisterLimitHigh(inChannel)])
+        {
+            registers[kADC128D818_RegisterInterruptStatus] |= (1 << inChannel);
+        }
+    }
+    else
+    {
+        uint16_t code = inDevice->inputs[inChannel] & 0x0FFF;
+        uint8_t limitCode = code >> kADC128D818_LimitShift;
+        inDevice->readings[inChannel] = code << 4;
+        if ((limitCode > registers[mADC128D818RegisterLimitHigh(inChannel)]) || (limitCode < registers[mADC128D818RegisterLimitLow(inChannel)]))
+        {
+            registers[kADC128D818_RegisterInterruptStatus] |= (1 << inChannel);
+        }
+    }
+
+    inDevice->readingsUs[inChannel] = inDevice->conversionEndUs;
+    inDevice->readingsReadMask &= ~(1 << inChannel);
+    inDevice->conversionCount ++;
+}
+
+// ----------------------------------------------------------------------------
+// Run the conversions of a device up to inTimeUs.
+static void ADC128D818SimUpdate(ADC128D818SimDevice_t* inDevice, uint64_t inTimeUs)
+{
+    while (true)
+    {
+        if (!inDevice->converting)
+        {
+            uint64_t startUs = (inDevice->nextCycleUs > inDevice->readyUs) ? inDevice->nextCycleUs : inDevice->readyUs;
+            uint8_t channel = ADC128D818SimNextChannel(inDevice, 0);
+            if (!ADC128D818SimIsRunning(inDevice) || (startUs > inTimeUs) || (channel == kADC128D818_MaxChannels))
+            {
+                return;
+            }
+
+            inDevice->converting = true;
+            inDevice->channel = channel;
+            inDevice->cycleStartUs = startUs;
+            inDevice->conversionEndUs = startUs + ADC128D818SimConversionUs(inDevice, channel);
+        }
+
+        if (inDevice->conversionEndUs > inTimeUs)
+        {
+            return;
+        }
+
+        ADC128D818SimConvert(inDevice, inDevice->channel);
+
+        uint8_t channel = ADC128D818SimNextChannel(inDevice, inDevice->channel + 1);
+        if (channel < kADC128D818_MaxChannels)
+        {
+            inDevice->channel = channel;
+            inDevice->conversionEndUs += ADC128D818SimConversionUs(inDevice, channel);
+            continue;
+        }
+
+        // Round robin done.
+        inDevice->converting = false;
+        if (inDevice->oneShot)
+        {
+            // Back to shutdown.
+            inDevice->oneShot = false;
+            inDevice->nextCycleUs = inDevice->conversionEndUs;
+        }
+        else if (inDevice->registers[kADC128D818_RegisterConversionRate] == kADC128D818_ConversionRate_Continuous)
+        {
+            inDevice->nextCycleUs = inDevice->conversionEndUs;
+        }
+        else
+        {
+            inDevice->nextCycleUs = inDevice->cycleStartUs + kADC128D818_LowPowerCycleUs;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+static void ADC128D818SimUpdateAll(void)
+{
+    for (uint8_t deviceIdx = 0; deviceIdx < kADC128D818SimMaxDevices; deviceIdx ++)
+    {
+        if (gSimDevices[deviceIdx].used)
+        {
+            ADC128D818SimUpdate(&gSimDevices[deviceIdx], gSimTimeUs);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Time of a transfer of inByteCount bytes on the bus of the device.
+static void ADC128D818SimTransfer(uint16_t inADCDevice, uint32_t inByteCount)
+{
+    uint8_t busID = mIOModBusDeviceBus(inADCDevice);
+    uint32_t speed = gSimBusSpeedSet[busID] ? gSimBusSpeed[busID] : kADC128D818SimBusSpeedDefault;
+
+    if (speed != 0)
+    {
+        uint32_t transferUs = (uint32_t)(((uint64_t)inByteCount * kADC128D818SimBitsPerByte * 1000000 + speed - 1) / speed);
+        gSimBusStats[busID].busUs += transferUs;
+        gSimTimeUs += transferUs;
+    }
+
+    ADC128D818SimUpdateAll();
+}
+
+// ----------------------------------------------------------------------------
+static uint8_t ADC128D818SimReadByte(ADC128D818SimDevice_t* inDevice, uint8_t inRegister)
+{
+    if (inRegister >= kADC128D818SimRegisterCount)
+    {
+        return 0;
+    }
+
+    if (inRegister == kADC128D818_RegisterBusyStatus)
+    {
+        uint8_t busyStatus = 0;
+        if (inDevice->converting)
+        {
+            busyStatus |= kADC128D818_RegisterBusyStatus_Busy;
+        }
+        if (gSimTimeUs < inDevice->readyUs)
+        {
+            busyStatus |= kADC128D818_RegisterBusyStatus_NotReady;
+        }
+        return busyStatus;
+    }
+
+    uint8_t value = inDevice->registers[inRegister];
+    if (inRegister == kADC128D818_RegisterInterruptStatus)
+    {
+        // Cleared by the read.
+        inDevice->registers[inRegister] = 0;
+    }
+
+    return value;
+}
+
+// ----------------------------------------------------------------------------
+static void ADC128D818SimWriteByte(ADC128D818SimDevice_t* inDevice, uint8_t inRegister, uint8_t inValue)
+{
+    switch (inRegister)
+    {
+        case kADC128D818_RegisterConfiguration:
+            if (inValue & kADC128D818_RegisterConfiguration_Init)
+            {
+                // Clears itself.
+                ADC128D818SimRestoreDefaults(inDevice);
+                break;
+            }
+            if ((inValue & kADC128D818_RegisterConfiguration_Start) && !(inDevice->registers[inRegister] & kADC128D818_RegisterConfiguration_Start))
+            {
+                inDevice->nextCycleUs = gSimTimeUs;
+            }
+            inDevice->registers[inRegister] = inValue;
+            // Stopped conversions are dropped.
+            if (!ADC128D818SimIsRunning(inDevice))
+            {
+                inDevice->converting = false;
+            }
+            break;
+        case kADC128D818_RegisterOneShot:
+            // Only from shutdown or deep shutdown.
+            if ((inValue & kADC128D818_RegisterOneShot_OneShot) && !(inDevice->registers[kADC128D818_RegisterConfiguration] & kADC128D818_RegisterConfiguration_Start) && !inDevice->oneShot)
+            {
+                inDevice->oneShot = true;
+                inDevice->nextCycleUs = gSimTimeUs;
+            }
+            break;
+        case kADC128D818_RegisterInterruptStatus:
+        case kADC128D818_RegisterBusyStatus:
+        case kADC128D818_RegisterManufacturerID:
+        case kADC128D818_RegisterRevisionID:
+            // Read only.
+            break;
+        default:
+            if ((inRegister < kADC128D818SimRegisterCount) && !mADC128D818IsChannelReadings(inRegister))
+            {
+                inDevice->registers[inRegister] = inValue;
+            }
+            break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimReset(void)
+{
+    memset(gSimDevices, 0, sizeof(gSimDevices));
+    memset(gSimBusStats, 0, sizeof(gSimBusStats));
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818SimAddDevice(uint16_t inADCDevice)
+{
+    if ((mIOModBusDeviceBus(inADCDevice) >= kIOModBusMax) || (ADC128D818SimGetDevice(inADCDevice) != NULL))
+    {
+        return -1;
+    }
+
+    for (uint8_t deviceIdx = 0; deviceIdx < kADC128D818SimMaxDevices; deviceIdx ++)
+    {
+        ADC128D818SimDevice_t* device = &gSimDevices[deviceIdx];
+        if (!device->used)
+        {
+            memset(device, 0, sizeof(*device));
+            device->used = true;
+            device->device = inADCDevice;
+            ADC128D818SimRestoreDefaults(device);
+            device->readyUs = gSimTimeUs;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimPowerCycle(uint16_t inADCDevice)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if (device != NULL)
+    {
+        ADC128D818SimRestoreDefaults(device);
+        device->readyUs = gSimTimeUs + kADC128D818_PowerUpUs;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimSetInput(uint16_t inADCDevice, uint8_t inChannel, uint16_t inCode)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if ((device != NULL) && (inChannel < kADC128D818_MaxChannels))
+    {
+        // Conversions done so far used the previous input.
+        ADC128D818SimUpdate(device, gSimTimeUs);
+        device->inputs[inChannel] = inCode;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimSetTemperature(uint16_t inADCDevice, int32_t inTemperature)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if (device != NULL)
+    {
+        ADC128D818SimUpdate(device, gSimTimeUs);
+        device->temperature = inTemperature;
+    }
+}
+
+// ----------------------------------------------------------------------------
+uint32_t ADC128D818SimGetConversionCount(uint16_t inADCDevice)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if (device == NULL)
+    {
+        return 0;
+    }
+
+    ADC128D818SimUpdate(device, gSimTimeUs);
+
+    return device->conversionCount;
+}
+
+// ----------------------------------------------------------------------------
+bool ADC128D818SimIsINTAsserted(uint16_t inADCDevice)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if (device == NULL)
+    {
+        return false;
+    }
+
+    ADC128D818SimUpdate(device, gSimTimeUs);
+
+    return (device->registers[kADC128D818_RegisterConfiguration] & kADC128D818_RegisterConfiguration_INT_Enable) &&
+           (device->registers[kADC128D818_RegisterInterruptStatus] & ~device->registers[kADC128D818_RegisterInterruptMask]);
+}
+
+// ----------------------------------------------------------------------------
+uint64_t ADC128D818SimGetTimeUs(void)
+{
+    return gSimTimeUs;
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimAdvance(uint32_t inUs)
+{
+    gSimTimeUs += inUs;
+    ADC128D818SimUpdateAll();
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimSetBusSpeed(uint8_t inBusID, uint32_t inSpeedHz)
+{
+    if (inBusID < kIOModBusMax)
+    {
+        gSimBusSpeed[inBusID] = inSpeedHz;
+        gSimBusSpeedSet[inBusID] = true;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimGetBusStats(uint8_t inBusID, ADC128D818SimBusStats_t* outStats)
+{
+    if (inBusID < kIOModBusMax)
+    {
+        *outStats = gSimBusStats[inBusID];
+    }
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818SimReadRegister(uint16_t inADCDevice, uint8_t inRegister, uint8_t* outData, uint16_t inSize)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if (mIOModBusDeviceBus(inADCDevice) >= kIOModBusMax)
+    {
+        return -1;
+    }
+
+    if (device == NULL)
+    {
+        // Address byte not acknowledged.
+        ADC128D818SimTransfer(inADCDevice, 1);
+        gSimBusStats[mIOModBusDeviceBus(inADCDevice)].nacks ++;
+        return -1;
+    }
+
+    // Address + register, address + data.
+    ADC128D818SimTransfer(inADCDevice, 3 + inSize);
+    ADC128D818SimBusStats_t* stats = &gSimBusStats[mIOModBusDeviceBus(inADCDevice)];
+    stats->reads ++;
+
+    if (mADC128D818IsChannelReadings(inRegister))
+    {
+        // 16-bit, MSByte first.
+        uint8_t channel = inRegister - kADC128D818_RegisterChannel0Read;
+        for (uint16_t dataIdx = 0; dataIdx < inSize; dataIdx ++)
+        {
+            outData[dataIdx] = (dataIdx == 0) ? (device->readings[channel] >> 8) : (dataIdx == 1) ? (device->readings[channel] & 0xFF) : 0;
+        }
+
+        stats->readingReads ++;
+        if (device->readingsReadMask & (1 << channel))
+        {
+            stats->staleReadingReads ++;
+        }
+        device->readingsReadMask |= (1 << channel);
+        stats->readingAgeUs += gSimTimeUs - device->readingsUs[channel];
+        return 0;
+    }
+
+    for (uint16_t dataIdx = 0; dataIdx < inSize; dataIdx ++)
+    {
+        outData[dataIdx] = ADC128D818SimReadByte(device, inRegister + dataIdx);
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+int ADC128D818SimWriteRegister(uint16_t inADCDevice, uint8_t inRegister, uint8_t* inData, uint16_t inSize)
+{
+    ADC128D818SimDevice_t* device = ADC128D818SimGetDevice(inADCDevice);
+
+    if (mIOModBusDeviceBus(inADCDevice) >= kIOModBusMax)
+    {
+        return -1;
+    }
+
+    if (device == NULL)
+    {
+        ADC128D818SimTransfer(inADCDevice, 1);
+        gSimBusStats[mIOModBusDeviceBus(inADCDevice)].nacks ++;
+        return -1;
+    }
+
+    // Address + register + data.
+    ADC128D818SimTransfer(inADCDevice, 2 + inSize);
+    gSimBusStats[mIOModBusDeviceBus(inADCDevice)].writes ++;
+
+    for (uint16_t dataIdx = 0; dataIdx < inSize; dataIdx ++)
+    {
+        ADC128D818SimWriteByte(device, inRegister + dataIdx, inData[dataIdx]);
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Port hooks have no bus argument, one pair of functions per bus.
+#define mADC128D818SimBusFunctions(bus) \
+static int ADC128D818SimReadRegisterBus##bus(uint8_t inAddress, uint8_t inRegister, uint8_t* outData, uint16_t inSize) \
+{ \
+    return ADC128D818SimReadRegister(mIOModBusDevice(bus, inAddress), inRegister, outData, inSize); \
+} \
+static int ADC128D818SimWriteRegisterBus##bus(uint8_t inAddress, uint8_t inRegister, uint8_t* inData, uint16_t inSize) \
+{ \
+    return ADC128D818SimWriteRegister(mIOModBusDevice(bus, inAddress), inRegister, inData, inSize); \
+}
+
+mADC128D818SimBusFunctions(0)
+mADC128D818SimBusFunctions(1)
+mADC128D818SimBusFunctions(2)
+mADC128D818SimBusFunctions(3)
+
+static const IOModBusReadRegister_t kADC128D818SimReadFunctions[] =
+{
+    ADC128D818SimReadRegisterBus0,
+    ADC128D818SimReadRegisterBus1,
+    ADC128D818SimReadRegisterBus2,
+    ADC128D818SimReadRegisterBus3,
+};
+static const IOModBusWriteRegister_t kADC128D818SimWriteFunctions[] =
+{
+    ADC128D818SimWriteRegisterBus0,
+    ADC128D818SimWriteRegisterBus1,
+    ADC128D818SimWriteRegisterBus2,
+    ADC128D818SimWriteRegisterBus3,
+};
+
+_Static_assert(kIOModBusMax <= sizeof(kADC128D818SimReadFunctions) / sizeof(kADC128D818SimReadFunctions[0]), "Add bus functions for kIOModBusMax buses");
+
+// ----------------------------------------------------------------------------
+void ADC128D818SimGetPort(uint8_t inBusID, IOModBusPort_t* outPort)
+{
+    memset(outPort, 0, sizeof(*outPort));
+
+    if (inBusID < kIOModBusMax)
+    {
+        outPort->readRegister = kADC128D818SimReadFunctions[inBusID];
+        outPort->writeRegister = kADC128D818SimWriteFunctions[inBusID];
+    }
+}
+
+// ----------------------------------------------------------------------------
+int I2CReadRegister(uint8_t inAddress, uint8_t inRegister, uint8_t* outData, uint16_t inSize)
+{
+    return ADC128D818SimReadRegisterBus0(inAddress, inRegister, outData, inSize);
+}
+
+// ----------------------------------------------------------------------------
+int I2CWriteRegister(uint8_t inAddress, uint8_t inRegister, uint8_t* inData, uint16_t inSize)
+{
+    return ADC128D818SimWriteRegisterBus0(inAddress, inRegister, inData, inSize);
+}
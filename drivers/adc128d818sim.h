@@ -0,0 +1,102 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef ADC128D818SIM_H_
+#define ADC128D818SIM_H_
+
+// Host simulation of ADC128D818 devices, to run the driver and IOMod on a workstation (tests, benchmarks).
+// Register map, round robin timing (kADC128D818_VoltageConversionUs / kADC128D818_TemperatureConversionUs), conversion
+// rates, one-shot, busy status, limits and INT. Pseudo-differential modes convert as single-ended.
+// Time is simulated: it advances with ADC128D818SimAdvance and with the duration of each register access.
+
+// Standard includes.
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lib includes.
+#include "iomodbus.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+// I2C clock of the buses, 0 for transfers taking no time.
+#ifndef kADC128D818SimBusSpeedDefault
+#define kADC128D818SimBusSpeedDefault 400000
+#endif
+
+// ----------------------------------------------------------------------------
+// Data types
+// ----------------------------------------------------------------------------
+typedef struct
+{
+    // Register accesses acknowledged by a device.
+    uint32_t reads;
+    uint32_t writes;
+    // Accesses to an address without device.
+    uint32_t nacks;
+    // Time spent transferring.
+    uint64_t busUs;
+    // Channel readings read, and those already read since their conversion.
+    uint32_t readingReads;
+    uint32_t staleReadingReads;
+    // Sum of the reading ages (time since the end of their conversion) when read.
+    uint64_t readingAgeUs;
+} ADC128D818SimBusStats_t;
+
+// ----------------------------------------------------------------------------
+// Function prototypes
+// ----------------------------------------------------------------------------
+/// Remove all devices and clear the bus statistics, the time keeps going.
+void ADC128D818SimReset(void);
+/// Add a device at inADCDevice (mIOModBusDevice(bus, address)), powered up. Returns -1 if it can not be added.
+int ADC128D818SimAddDevice(uint16_t inADCDevice);
+/// Power cycle a device: registers back to their defaults, not ready for kADC128D818_PowerUpUs.
+void ADC128D818SimPowerCycle(uint16_t inADCDevice);
+/// Voltage input of a channel, as its 12-bit code.
+void ADC128D818SimSetInput(uint16_t inADCDevice, uint8_t inChannel, uint16_t inCode);
+/// Internal temperature in milli-degrees C, converted with 0.5 C resolution.
+void ADC128D818SimSetTemperature(uint16_t inADCDevice, int32_t inTemperature);
+/// Conversions completed by a device.
+uint32_t ADC128D818SimGetConversionCount(uint16_t inADCDevice);
+/// INT output, active when an unmasked interrupt status bit is set and INT_Enable is set.
+bool ADC128D818SimIsINTAsserted(uint16_t inADCDevice);
+/// Simulated time.
+uint64_t ADC128D818SimGetTimeUs(void);
+/// Let inUs pass, conversions progress.
+void ADC128D818SimAdvance(uint32_t inUs);
+/// I2C clock of a bus, kADC128D818SimBusSpeedDefault by default.
+void ADC128D818SimSetBusSpeed(uint8_t inBusID, uint32_t inSpeedHz);
+/// Statistics of a bus since ADC128D818SimReset.
+void ADC128D818SimGetBusStats(uint8_t inBusID, ADC128D818SimBusStats_t* outStats);
+/// Register access hooks of a bus, for IOModBusInit.
+void ADC128D818SimGetPort(uint8_t inBusID, IOModBusPort_t* outPort);
+/// Register access of the simulated devices. Bus 0 is also exported as I2CReadRegister / I2CWriteRegister, link the
+/// simulator in place of the I2C driver.
+int ADC128D818SimReadRegister(uint16_t inADCDevice, uint8_t inRegister, uint8_t* outData, uint16_t inSize);
+int ADC128D818SimWriteRegister(uint16_t inADCDevice, uint8_t inRegister, uint8_t* inData, uint16_t inSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADC128D818SIM_H_
@@ -0,0 +1,76 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+// Samples per second of USP10973BetaComputeTemperature, USP10973ComputeTemperature and USP10973ComputeTemperatureBatch.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "usp10973.h"
+};
+
+static const uint32_t kSampleCount = 1 << 20;
+static const uint32_t kRepeatCount = 20;
+
+template <typename Function>
+static double SamplesPerSecond(Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t repeatIdx = 0; repeatIdx < kRepeatCount; repeatIdx ++)
+    {
+        function();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return (double)kSampleCount * kRepeatCount / elapsed.count();
+}
+
+int main()
+{
+    std::vector<uint16_t> input(kSampleCount);
+    std::vector<int32_t> output(kSampleCount);
+    std::mt19937 generator(1);
+
+    for (auto& value : input)
+    {
+        value = generator() & 0x0FFF;
+    }
+
+    double beta = SamplesPerSecond([&]() {
+        for (uint32_t sampleIdx = 0; sampleIdx < kSampleCount; sampleIdx ++)
+        {
+            USP10973BetaComputeTemperature(input[sampleIdx], &output[sampleIdx]);
+        }
+    });
+    double scalar = SamplesPerSecond([&]() {
+        for (uint32_t sampleIdx = 0; sampleIdx < kSampleCount; sampleIdx ++)
+        {
+            USP10973ComputeTemperature(input[sampleIdx], &output[sampleIdx]);
+        }
+    });
+    double batch = SamplesPerSecond([&]() {
+        USP10973ComputeTemperatureBatch(input.data(), output.data(), kSampleCount);
+    });
+
+    printf("USP10973: beta %.1f Msamples/s, table %.1f Msamples/s, batch %.1f Msamples/s\n", beta / 1e6, scalar / 1e6, batch / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+extern "C" {
+#include "usp10973.h"
+};
+
+// Worst case interpolation error with kUSP10973TableShift 3, in milli-degrees C.
+static const int32_t kTolerance = 200;
+static const uint16_t kCodeCount = 1 << 12;
+
+TEST(GivenLookupTable, WhenZeroCodeThenShouldReturnError){
+    int32_t temperature;
+    EXPECT_EQ(USP10973BetaComputeTemperature(0, &temperature), -1);
+    EXPECT_EQ(USP10973ComputeTemperature(0, &temperature), -1);
+}
+
+TEST(GivenLookupTable, WhenCodeAboveResolutionThenShouldReturnError){
+    int32_t temperature;
+    EXPECT_EQ(USP10973ComputeTemperature(kCodeCount, &temperature), -1);
+    EXPECT_EQ(USP10973ComputeTemperature(0xFFFF, &temperature), -1);
+}
+
+TEST(GivenLookupTable, WhenAllCodesConvertedThenShouldMatchBetaEquation){
+    uint16_t validCodes = 0;
+
+    for (uint32_t code = 0; code < kCodeCount; code ++)
+    {
+        int32_t expected = 0;
+        int32_t temperature = 0;
+        int expectedStatus = USP10973BetaComputeTemperature(code, &expected);
+
+        ASSERT_EQ(USP10973ComputeTemperature(code, &temperature), expectedStatus) << "code " << code;
+        if (expectedStatus == 0)
+        {
+            EXPECT_LE(abs(temperature - expected), kTolerance) << "code " << code;
+            validCodes ++;
+        }
+    }
+
+    // [-40, 150]C must be covered.
+    EXPECT_GT(validCodes, 3000);
+}
+
+TEST(GivenLookupTable, WhenCodesIncreaseThenTemperatureShouldIncrease){
+    int32_t previous = INT32_MIN;
+
+    for (uint32_t code = 0; code < kCodeCount; code ++)
+    {
+        int32_t temperature;
+        if (USP10973ComputeTemperature(code, &temperature) == 0)
+        {
+            EXPECT_GE(temperature, previous) << "code " << code;
+            previous = temperature;
+        }
+    }
+}
+
+TEST(GivenLookupTable, WhenAllCodesConvertedInBatchThenShouldMatchScalar){
+    static uint16_t codes[UINT16_MAX + 1];
+    static int32_t temperatures[UINT16_MAX + 1];
+    uint32_t invalidCount = 0;
+
+    for (uint32_t code = 0; code <= UINT16_MAX; code ++)
+    {
+        codes[code] = code;
+    }
+
+    uint32_t batchInvalidCount = USP10973ComputeTemperatureBatch(codes, temperatures, UINT16_MAX + 1);
+
+    for (uint32_t code = 0; code <= UINT16_MAX; code ++)
+    {
+        int32_t temperature;
+        if (USP10973ComputeTemperature(code, &temperature) == 0)
+        {
+            ASSERT_EQ(temperatures[code], temperature) << "code " << code;
+        }
+        else
+        {
+            ASSERT_EQ(temperatures[code], kUSP10973InvalidTemperature) << "code " << code;
+            invalidCount ++;
+        }
+    }
+
+    EXPECT_EQ(batchInvalidCount, invalidCount);
+}
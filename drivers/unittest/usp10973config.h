@@ -0,0 +1,27 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef USP10973CONFIG_H_
+#define USP10973CONFIG_H_
+
+// Test configuration for usp10973.c.
+#define kRREF 10000
+#define kADCResolution 12
+#define kUSP10973TableShift 3
+
+#endif // USP10973CONFIG_H_
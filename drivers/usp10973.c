@@ -9,6 +9,9 @@
  
 // Standard includes.
 #include <math.h>
+#ifdef kUSP10973TableGenerator
+#include <stdio.h>
+#endif
 
 // Common includes.
 #include "usp10973.h"
@@ -22,62 +25,230 @@
 #error "ADC resolution not defined (ex: #define kADCResolution 12)."
 #endif
 
+// Lookup table has one entry every (1 << kUSP10973TableShift) ADC codes, values in between are interpolated.
+// Worst case interpolation error is ~0.2C above 125C with the default shift of 3 (513 entries).
+#ifndef kUSP10973TableShift
+#define kUSP10973TableShift 3
+#endif
+
 // kADCMaxValue *= RREF to simplify computation.
 #define kADCMaxValue ((1 << kADCResolution) - 1) * kRREF
+#define kUSP10973TableSize ((1 << (kADCResolution - kUSP10973TableShift)) + 1)
+
+// Lookup table generated at build time by usp10973_tablegen (see usp10973table.cmake).
+#ifndef kUSP10973TableGenerator
+#include "usp10973table.h"
+
+_Static_assert((kUSP10973TableRREF == kRREF) && (kUSP10973TableADCResolution == kADCResolution) && (kUSP10973TableShiftValue == kUSP10973TableShift), "usp10973table.h does not match usp10973config.h, regenerate it");
+_Static_assert(sizeof(kUSP10973Table) / sizeof(kUSP10973Table[0]) == kUSP10973TableSize, "usp10973table.h size mismatch");
+#endif
 
 // ----------------------------------------------------------------------------
-int USP10973BetaComputeTemperature(uint16_t inRawADCValue, int32_t* outTemperature)
+// Get resistance value of the thermistor (valueR2 = ((RREF * VREF) / VADC) - RREF).
+static uint32_t USP10973ComputeResistance(uint16_t inRawADCValue)
 {
-    int status = 0;
-
-    // Get resistance value of the thermistor (valueR2 = ((RREF * VREF) / VADC) - RREF).
     // FIXME: Linux platform (uint32_t)kADCMaxValue does not work?
-    uint32_t valueR2 = (((uint32_t)kADCMaxValue / (uint32_t)inRawADCValue) - (uint32_t)kRREF);
-
-    double beta = 0;
-    double valueR1 = 0;
-    double valueT1 = 0;
+    return (((uint32_t)kADCMaxValue / (uint32_t)inRawADCValue) - (uint32_t)kRREF);
+}
 
-    // Apply coefficients according to the resistance range.
-    if ((valueR2 <= kR1_m40_0) && (valueR2 > kR1_0_50))
+// ----------------------------------------------------------------------------
+// Apply coefficients according to the resistance range, returns -1 if out of range.
+static int USP10973BetaCoefficients(uint32_t inValueR2, double* outBeta, double* outT1, double* outR1)
+{
+    if ((inValueR2 <= kR1_m40_0) && (inValueR2 > kR1_0_50))
     {
         // Beta for [-40 0]C.
-        beta = (double)kBeta_m40_0;
-        valueT1 = (double)kT1_m40_0;
-        valueR1 = (double)kR1_m40_0;
+        *outBeta = (double)kBeta_m40_0;
+        *outT1 = (double)kT1_m40_0;
+        *outR1 = (double)kR1_m40_0;
     }
-    else if ((valueR2 <= kR1_0_50) && (valueR2 > kR1_50_100))
+    else if ((inValueR2 <= kR1_0_50) && (inValueR2 > kR1_50_100))
     {
         // Beta for [0 50]C.
-        beta = (double)kBeta_0_50;
-        valueT1 = (double)kT1_0_50;
-        valueR1 = (double)kR1_0_50;
+        *outBeta = (double)kBeta_0_50;
+        *outT1 = (double)kT1_0_50;
+        *outR1 = (double)kR1_0_50;
     }
-    else if ((valueR2 <= kR1_50_100) && (valueR2 > kR1_100_150))
+    else if ((inValueR2 <= kR1_50_100) && (inValueR2 > kR1_100_150))
     {
         // Beta for [50 100]C.
-        beta = (double)kBeta_50_100;
-        valueT1 = (double)kT1_50_100;
-        valueR1 = (double)kR1_50_100;
+        *outBeta = (double)kBeta_50_100;
+        *outT1 = (double)kT1_50_100;
+        *outR1 = (double)kR1_50_100;
     }
-    else if ((valueR2 <= kR1_100_150) && (valueR2 > kR1_150_200))
+    else if ((inValueR2 <= kR1_100_150) && (inValueR2 > kR1_150_200))
     {
         // Extended range (above 105 C).
         // TODO: Calculate new beta.
-        beta = (double)kBeta_50_100;
-        valueT1 = (double)kT1_50_100;
-        valueR1 = (double)kR1_50_100;
+        *outBeta = (double)kBeta_50_100;
+        *outT1 = (double)kT1_50_100;
+        *outR1 = (double)kR1_50_100;
     }
     else
     {
         // Resistance out of range, invalid for conversion.
-        return status = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Simplified Steinhart-Hart equation (for Beta parameter) - result on 3 decimal points.
+static double USP10973BetaEquation(double inValueR2, double inBeta, double inValueT1, double inValueR1)
+{
+    double lnResult = log(inValueR2 / inValueR1);
+
+    return ((inBeta * inValueT1) / (inBeta + lnResult * inValueT1) - (double)kKelvinConstant) * (double)1000;
+}
+
+// ----------------------------------------------------------------------------
+int USP10973BetaComputeTemperature(uint16_t inRawADCValue, int32_t* outTemperature)
+{
+    double beta = 0;
+    double valueR1 = 0;
+    double valueT1 = 0;
+
+    // No current through the thermistor (open), invalid for conversion.
+    if (inRawADCValue == 0)
+    {
+        return -1;
+    }
+
+    uint32_t valueR2 = USP10973ComputeResistance(inRawADCValue);
+
+    if (USP10973BetaCoefficients(valueR2, &beta, &valueT1, &valueR1) != 0)
+    {
+        return -1;
     }
 
-    double lnResult = log((double)valueR2 / valueR1);
-    // Simplified Steinhart-Hart equation (for Beta parameter) - result on 3 decimal points.
-    *outTemperature = (int32_t)(((beta * valueT1) / (beta + lnResult * valueT1) - (double)kKelvinConstant) * (double)1000);
+    *outTemperature = (int32_t)USP10973BetaEquation((double)valueR2, beta, valueT1, valueR1);
 
     // Value is in range, success.
-    return status;
+    return 0;
+}
+
+#ifdef kUSP10973TableGenerator
+// ----------------------------------------------------------------------------
+int USP10973GenerateTable(FILE* inFile)
+{
+    // Valid codes are contiguous as the resistance decreases with the code.
+    uint16_t minCode = 0;
+    uint16_t maxCode = 0;
+    for (uint32_t code = 1; code < (1 << kADCResolution); code ++)
+    {
+        double beta, valueT1, valueR1;
+        if (USP10973BetaCoefficients(USP10973ComputeResistance(code), &beta, &valueT1, &valueR1) == 0)
+        {
+            if (minCode == 0)
+            {
+                minCode = code;
+            }
+            maxCode = code;
+        }
+    }
+
+    if (minCode == 0)
+    {
+        return -1;
+    }
+
+    fprintf(inFile, "// Generated by usp10973_tablegen, do not edit.\n");
+    fprintf(inFile, "#ifndef USP10973TABLE_H_\n#define USP10973TABLE_H_\n\n");
+    fprintf(inFile, "#define kUSP10973TableRREF %d\n", (int)kRREF);
+    fprintf(inFile, "#define kUSP10973TableADCResolution %d\n", (int)kADCResolution);
+    fprintf(inFile, "#define kUSP10973TableShiftValue %d\n", (int)kUSP10973TableShift);
+    fprintf(inFile, "#define kUSP10973MinCode %u\n", (unsigned)minCode);
+    fprintf(inFile, "#define kUSP10973MaxCode %u\n\n", (unsigned)maxCode);
+    fprintf(inFile, "// Temperature in milli-degrees C every (1 << kUSP10973TableShift) ADC codes.\n");
+    fprintf(inFile, "static const int32_t kUSP10973Table[%d] =\n{\n", kUSP10973TableSize);
+
+    // Entries outside of the valid range extend the closest range so interpolation near the limits stays accurate.
+    for (uint32_t tableIdx = 0; tableIdx < kUSP10973TableSize; tableIdx ++)
+    {
+        uint32_t code = tableIdx << kUSP10973TableShift;
+        if (code == 0)
+        {
+            code = 1;
+        }
+        else if (code >= (1 << kADCResolution))
+        {
+            code = (1 << kADCResolution) - 1;
+        }
+
+        double valueR2 = (double)USP10973ComputeResistance(code);
+        double beta, valueT1, valueR1;
+        if (USP10973BetaCoefficients(valueR2, &beta, &valueT1, &valueR1) != 0)
+        {
+            if (valueR2 > kR1_m40_0)
+            {
+                beta = (double)kBeta_m40_0;
+                valueT1 = (double)kT1_m40_0;
+                valueR1 = (double)kR1_m40_0;
+            }
+            else
+            {
+                beta = (double)kBeta_50_100;
+                valueT1 = (double)kT1_50_100;
+                valueR1 = (double)kR1_50_100;
+                if (valueR2 < 1)
+                {
+                    valueR2 = 1;
+                }
+            }
+        }
+
+        // Round to nearest.
+        double temperature = USP10973BetaEquation(valueR2, beta, valueT1, valueR1);
+        fprintf(inFile, "    %ld,\n", (long)(temperature < 0 ? temperature - 0.5 : temperature + 0.5));
+    }
+
+    fprintf(inFile, "};\n\n#endif // USP10973TABLE_H_\n");
+
+    return 0;
+}
+#else
+// ----------------------------------------------------------------------------
+int USP10973ComputeTemperature(uint16_t inRawADCValue, int32_t* outTemperature)
+{
+    // Same range as USP10973BetaComputeTemperature.
+    if ((inRawADCValue < kUSP10973MinCode) || (inRawADCValue > kUSP10973MaxCode))
+    {
+        return -1;
+    }
+
+    uint16_t tableIdx = inRawADCValue >> kUSP10973TableShift;
+    int32_t fraction = inRawADCValue & ((1 << kUSP10973TableShift) - 1);
+    int32_t lowValue = kUSP10973Table[tableIdx];
+    int32_t highValue = kUSP10973Table[tableIdx + 1];
+
+    *outTemperature = lowValue + (((highValue - lowValue) * fraction) >> kUSP10973TableShift);
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+uint32_t USP10973ComputeTemperatureBatch(const uint16_t inRawADCValues[], int32_t outTemperatures[], uint32_t inCount)
+{
+    uint32_t invalidCount = 0;
+
+    // Same result as USP10973ComputeTemperature, branch free so the compiler can vectorize it (-O3 with gathers, ex: AVX2).
+    for (uint32_t valueIdx = 0; valueIdx < inCount; valueIdx ++)
+    {
+        uint16_t rawADCValue = inRawADCValues[valueIdx];
+        int valid = (rawADCValue >= kUSP10973MinCode) && (rawADCValue <= kUSP10973MaxCode);
+        // Clamp so the lookup stays in the table for invalid codes.
+        uint16_t code = (rawADCValue < kUSP10973MinCode) ? kUSP10973MinCode : ((rawADCValue > kUSP10973MaxCode) ? kUSP10973MaxCode : rawADCValue);
+        uint16_t tableIdx = code >> kUSP10973TableShift;
+        int32_t fraction = code & ((1 << kUSP10973TableShift) - 1);
+        int32_t lowValue = kUSP10973Table[tableIdx];
+        int32_t highValue = kUSP10973Table[tableIdx + 1];
+        int32_t temperature = lowValue + (((highValue - lowValue) * fraction) >> kUSP10973TableShift);
+
+        outTemperatures[valueIdx] = valid ? temperature : kUSP10973InvalidTemperature;
+        invalidCount += !valid;
+    }
+
+    return invalidCount;
 }
+#endif // kUSP10973TableGenerator
@@ -24,6 +24,9 @@ extern "C"
 // Kelvin constant for conversion in Celsius.
 #define kKelvinConstant 273.15
 
+// Out of range marker of USP10973ComputeTemperatureBatch.
+#define kUSP10973InvalidTemperature INT32_MIN
+
 // Beta coefficients
 // ---------------------------
 // Coefficients for temperature range [-40, 0]C.
@@ -52,8 +55,12 @@ extern "C"
 // ----------------------------------------------------------------------------
 // Function prototypes
 // ----------------------------------------------------------------------------
-///
+/// Reference conversion (double, log()), temperature in milli-degrees C. Returns -1 if out of range.
 int USP10973BetaComputeTemperature(uint16_t inRawADCValue, int32_t* outTemperature);
+/// Integer lookup table conversion, same range as USP10973BetaComputeTemperature. Needs usp10973table.h (see usp10973table.cmake).
+int USP10973ComputeTemperature(uint16_t inRawADCValue, int32_t* outTemperature);
+/// USP10973ComputeTemperature on inCount values, out of range values are set to kUSP10973InvalidTemperature. Returns the number of out of range values.
+uint32_t USP10973ComputeTemperatureBatch(const uint16_t inRawADCValues[], int32_t outTemperatures[], uint32_t inCount);
 
 #ifdef __cplusplus
 }
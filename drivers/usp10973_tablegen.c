@@ -0,0 +1,44 @@
+// ----------------------------------------------------------------------------
+// usp10973_tablegen.c
+//
+// Copyright (C) 2016 GRR Systems <marc-andre.guimond@grr-systems.com>.
+// All rights reserved.
+//
+// This file is encoded in UTF-8.
+// ---------------------------------------------------------------------------
+
+// Host tool generating usp10973table.h from the board usp10973config.h.
+// Built with usp10973.c and kUSP10973TableGenerator defined, see usp10973table.cmake.
+
+// Standard includes.
+#include <stdio.h>
+
+int USP10973GenerateTable(FILE* inFile);
+
+// ----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <usp10973table.h>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "w");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    int status = USP10973GenerateTable(file);
+    fclose(file);
+    if (status != 0)
+    {
+        fprintf(stderr, "No ADC code in the thermistor range, check usp10973config.h.\n");
+        remove(argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
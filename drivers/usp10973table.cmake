@@ -0,0 +1,40 @@
+# Generate usp10973table.h for a target from its usp10973config.h.
+#
+#   include(iomodlib/drivers/usp10973table.cmake)
+#   usp10973_table(<target> <directory containing usp10973config.h>)
+#
+# The generator runs on the build machine, set USP10973_HOST_CC when the
+# default host compiler (cc) is not the right one.
+
+set(USP10973_TABLE_SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+if(NOT DEFINED USP10973_HOST_CC)
+    set(USP10973_HOST_CC cc)
+endif()
+
+function(usp10973_table TARGET CONFIG_DIR)
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/usp10973table_${TARGET})
+    set(GENERATOR ${OUTPUT_DIR}/usp10973_tablegen)
+
+    add_custom_command(
+            OUTPUT ${OUTPUT_DIR}/usp10973table.h
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+            COMMAND ${USP10973_HOST_CC} -std=gnu99 -DkUSP10973TableGenerator
+                    -I${CONFIG_DIR} -I${USP10973_TABLE_SOURCE_DIR}
+                    -o ${GENERATOR}
+                    ${USP10973_TABLE_SOURCE_DIR}/usp10973_tablegen.c
+                    ${USP10973_TABLE_SOURCE_DIR}/usp10973.c
+                    -lm
+            COMMAND ${GENERATOR} ${OUTPUT_DIR}/usp10973table.h
+            DEPENDS
+                    ${CONFIG_DIR}/usp10973config.h
+                    ${USP10973_TABLE_SOURCE_DIR}/usp10973.c
+                    ${USP10973_TABLE_SOURCE_DIR}/usp10973.h
+                    ${USP10973_TABLE_SOURCE_DIR}/usp10973_tablegen.c
+            COMMENT "Generating usp10973table.h for ${TARGET}"
+            VERBATIM
+            )
+
+    target_sources(${TARGET} PRIVATE ${OUTPUT_DIR}/usp10973table.h)
+    target_include_directories(${TARGET} PRIVATE ${OUTPUT_DIR})
+endfunction()
@@ -16,8 +16,16 @@
  * This file is encoded in UTF-8.
  */
 
+// Standard includes.
+#include <stdbool.h>
+#include <stddef.h>
+
 // Lib includes.
 #include "iomod.h"
+#include "iomodutils.h"
+#include "iomodstats.h"
+#include "iomodfilter.h"
+#include "iomodbus.h"
 #include "boardconfig.h"
 #include "conversion.h"
 #include "utils.h"
@@ -27,19 +35,539 @@
 #include "usp10973.h"
 
 // ----------------------------------------------------------------------------
+// Private types.
+// Single producer (scan engine) / multiple consumers ring, head only written by the producer.
+typedef struct
+{
+    IOModSample_t samples[kIOModSampleRingSize];
+    volatile uint32_t head;
+} IOModSampleRing_t;
+
+typedef enum
+{
+    kIOModInternalTemperatureState_Idle,
+    kIOModInternalTemperatureState_Settling,
+    // Back to previous mode, IN7 still holds a temperature conversion.
+    kIOModInternalTemperatureState_Restoring,
+} IOModInternalTemperatureState_e;
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t previousMode;
+    uint32_t startUs;
+    // Scan engine acquisition, disabled if periodUs is 0.
+    uint32_t periodUs;
+    uint32_t lastUs;
+    bool hasValue;
+    int32_t value;
+} IOModInternalTemperature_t;
+
+typedef struct
+{
+    // mA.
+    uint16_t limit;
+    // Raw ADC code, IOModDecodeCurrent(x) > limit if and only if x > limitRaw (calibration included).
+    uint16_t limitRaw;
+} IOModCurrentLimit_t;
+
+typedef struct
+{
+    IOModStatsAccumulator_t accumulator;
+    // IOModChannelType_e.
+    uint8_t type;
+    // Set by consumers, the scan engine does the reset (single writer).
+    volatile bool resetRequest;
+} IOModChannelStats_t;
+
+typedef struct
+{
+    IOModFilter_t filter;
+    bool enabled;
+    // Configuration posted by consumers, applied by the scan engine (single writer).
+    IOModFilterConfig_t requestConfig;
+    volatile bool request;
+    // Latest output, odd sequence while it is written.
+    volatile uint32_t sequence;
+    bool hasOutput;
+    IOModFilteredSample_t output;
+} IOModChannelFilter_t;
+
+typedef struct
+{
+    // Round robin started by the scan, not read yet.
+    bool converting;
+    bool triggered;
+    // Scan time of the latest start.
+    uint32_t triggerUs;
+    // Next start, once per period from the first one.
+    uint32_t nextUs;
+    // Between the two latest starts when the scan visits were too late to keep the period, 0 otherwise.
+    uint32_t periodUs;
+} IOModOneShot_t;
+
 // Private variables.
 IOMod_t gIOMod;
-static uint8_t gADCI2CAddressTable[kADC128D818_MaxAddresses];
+static uint16_t gADCDeviceTable[kIOModMaxSlaves];
+// Bit per slave of each bus (slave ID % kADC128D818_MaxAddresses).
+static uint16_t gADCInitializedMask[kIOModBusMax];
+static uint8_t gScanSlaveID[kIOModBusMax];
+static IOModSampleRing_t gSampleRings[kIOModMaxSlaves][kADC128D818_MaxChannels];
+static IOModInternalTemperature_t gInternalTemperature[kIOModMaxSlaves];
+static IOModChannelStats_t gChannelStats[kIOModMaxSlaves][kADC128D818_MaxChannels];
+static IOModChannelFilter_t gChannelFilters[kIOModMaxSlaves][kADC128D818_MaxChannels];
+// Bit per slave of each bus, valid once IOModDiscover is done.
+static uint16_t gADCPresentMask[kIOModBusMax];
+static bool gDiscoveryDone;
+static IOModBusTransaction_t gDiscoveryTransactions[kIOModMaxSlaves];
+static uint8_t gDiscoveryIDs[kIOModMaxSlaves];
+static IOModCurrentLimit_t gCurrentLimits[kIOModMaxSlaves][kADC128D818_MaxChannels];
+// Current conversion of each channel, fused at load time.
+static ConversionFused_t gCalibrations[kIOModMaxSlaves][kADC128D818_MaxChannels];
+// Bit per channel with a calibration set by IOModSetChannelCalibration.
+static uint8_t gCalibrationMask[kIOModMaxSlaves];
+// Bit per channel with a limit set by IOModSetCurrentLimit.
+static uint8_t gCurrentLimitMask[kIOModMaxSlaves];
+// Bit per channel, 0 (all converted) by default.
+static uint8_t gChannelDisableMask[kIOModMaxSlaves];
+// Period needed by each channel, valid if the channel bit of gChannelPeriodMask is set.
+static uint32_t gChannelPeriodUs[kIOModMaxSlaves][kADC128D818_MaxChannels];
+static uint8_t gChannelPeriodMask[kIOModMaxSlaves];
+static IOModOneShot_t gOneShots[kIOModMaxSlaves];
+// IOModReadIfNew time of the latest read of each channel, valid if the channel bit of gReadIfNewMask is set.
+static uint32_t gReadIfNewUs[kIOModMaxSlaves][kADC128D818_MaxChannels];
+static uint8_t gReadIfNewMask[kIOModMaxSlaves];
+// Bit per slave of each bus with alerts enabled.
+static uint16_t gADCAlertMask[kIOModBusMax];
+static IOModAlertCallback_t gAlertCallback;
+static void* gAlertContext;
+// Asynchronous scan batch (IOModScanSubmit).
+static IOModBusTransaction_t gScanTransactions[kIOModMaxSlaves * kADC128D818_MaxChannels];
+static uint8_t gScanReadings[kIOModMaxSlaves * kADC128D818_MaxChannels][2];
+static volatile uint16_t gScanPendingCount;
+static uint32_t gScanTimestampUs;
+static IOModPortStatus_e gScanStatus;
+static IOModScanCallback_t gScanCallback;
+static void* gScanContext;
+
+// Private constants.
+// Convert to mA: (300 / 2^12 - 1) * 2^16.
+#define kIOModCurrentMultiplier 4801
+#define kIOModCurrentScale 16
+
+// Current conversion of the channels without calibration.
+static const ConversionFused_t kIOModCurrentConversion = { kIOModCurrentMultiplier, kIOModCurrentScale, 1, 0 };
 
 // Private macros.
 #define mIOModValidateDriverStatus(returnStatus) if (returnStatus != 0) { return kIOModPortStatus_DriverBusError; }
+#define mIOModValidatePresent(slaveID) if (!IOModIsPresent(slaveID)) { return kIOModPortStatus_NotDetected; }
+#define mIOModIsInitialized(slaveID) ((gADCInitializedMask[(slaveID) / kADC128D818_MaxAddresses] & (1 << ((slaveID) % kADC128D818_MaxAddresses))) != 0)
+#define mIOModValidateInitialized(slaveID) if (!mIOModIsInitialized(slaveID)) { return kIOModPortStatus_NotDetected; }
+#define mIOModValidateChannelEnabled(slaveID, channelIdx) if (!(IOModGetActiveMask(slaveID) & (1 << (channelIdx)))) { return kIOModPortStatus_NotDetected; }
+
+_Static_assert(kIOModSlavesPerBus == kADC128D818_MaxAddresses, "One slave per ADC128D818 address on each bus");
+_Static_assert(kIOModChannelsPerSlave == kADC128D818_MaxChannels, "One channel per ADC128D818 input");
+_Static_assert((kIOModSampleRingSize & (kIOModSampleRingSize - 1)) == 0, "kIOModSampleRingSize must be a power of 2");
+
+// ----------------------------------------------------------------------------
+// Channels converted: the enabled ones, with a period if the slave has some.
+static uint8_t IOModGetActiveMask(uint8_t inSlaveID)
+{
+    uint8_t channelMask = (uint8_t)~gChannelDisableMask[inSlaveID];
+
+    if (gChannelPeriodMask[inSlaveID] != 0)
+    {
+        channelMask &= gChannelPeriodMask[inSlaveID];
+    }
+
+    return channelMask;
+}
+
+// ----------------------------------------------------------------------------
+static void IOModSetSchedulePeriod(uint8_t inSlaveID, IOModSchedule_t* outSchedule, uint32_t inPeriodUs)
+{
+    outSchedule->periodUs = inPeriodUs;
+    outSchedule->dutyCyclePpm = 0;
+    if (inPeriodUs != 0)
+    {
+        uint64_t dutyCyclePpm = (uint64_t)outSchedule->cycleUs * 1000000 / inPeriodUs;
+        outSchedule->dutyCyclePpm = (dutyCyclePpm > 1000000) ? 1000000 : (uint32_t)dutyCyclePpm;
+    }
+
+    outSchedule->missedMask = 0;
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if ((gChannelPeriodMask[inSlaveID] & (1 << channelIdx)) && (!(outSchedule->channelMask & (1 << channelIdx)) || (gChannelPeriodUs[inSlaveID][channelIdx] < inPeriodUs)))
+        {
+            outSchedule->missedMask |= (1 << channelIdx);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Conversion mode of a slave from its converted channels and the shortest period they need.
+static void IOModPlanSchedule(uint8_t inSlaveID, IOModSchedule_t* outSchedule)
+{
+    uint8_t mode = kADC128D818_Mode_SingleEnded;
+    uint32_t requiredUs = UINT32_MAX;
+
+    // Mode from the driver register cache, set by ADC128D818Init.
+    if (mIOModIsInitialized(inSlaveID) && (ADC128D818GetMode(gADCDeviceTable[inSlaveID], &mode) != 0))
+    {
+        mode = kADC128D818_Mode_SingleEnded;
+    }
+
+    outSchedule->channelMask = IOModGetActiveMask(inSlaveID);
+    outSchedule->cycleUs = ADC128D818CycleUs(outSchedule->channelMask, mode);
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if ((outSchedule->channelMask & gChannelPeriodMask[inSlaveID] & (1 << channelIdx)) && (gChannelPeriodUs[inSlaveID][channelIdx] < requiredUs))
+        {
+            requiredUs = gChannelPeriodUs[inSlaveID][channelIdx];
+        }
+    }
+
+    if (outSchedule->channelMask == 0)
+    {
+        outSchedule->mode = kIOModScheduleMode_Shutdown;
+        IOModSetSchedulePeriod(inSlaveID, outSchedule, 0);
+    }
+    else if ((gChannelPeriodMask[inSlaveID] != 0) && (requiredUs >= kIOModOneShotPeriodMinUs) && (requiredUs > outSchedule->cycleUs))
+    {
+        outSchedule->mode = kIOModScheduleMode_OneShot;
+        IOModSetSchedulePeriod(inSlaveID, outSchedule, requiredUs);
+    }
+    else if ((gChannelPeriodMask[inSlaveID] != 0) && (requiredUs >= kADC128D818_LowPowerCycleUs))
+    {
+        // Round robins are shorter than the low power cycle.
+        outSchedule->mode = kIOModScheduleMode_LowPower;
+        IOModSetSchedulePeriod(inSlaveID, outSchedule, kADC128D818_LowPowerCycleUs);
+    }
+    else
+    {
+        outSchedule->mode = kIOModScheduleMode_Continuous;
+        IOModSetSchedulePeriod(inSlaveID, outSchedule, outSchedule->cycleUs);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Program the converted channels and conversion mode of a slave.
+static int IOModApplySchedule(uint8_t inSlaveID)
+{
+    uint16_t adcDevice = gADCDeviceTable[inSlaveID];
+    IOModSchedule_t schedule;
+
+    gOneShots[inSlaveID].converting = false;
+    gOneShots[inSlaveID].triggered = false;
+    gOneShots[inSlaveID].periodUs = 0;
+    IOModPlanSchedule(inSlaveID, &schedule);
+
+    int status = ADC128D818SetChannelMask(adcDevice, schedule.channelMask);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    switch (schedule.mode)
+    {
+        case kIOModScheduleMode_Continuous:
+        case kIOModScheduleMode_LowPower:
+            status = ADC128D818DeepShutdown(adcDevice, kADC128D818_RegisterDeepShutdown_DeepShutdownDisable);
+            if (status == 0)
+            {
+                status = ADC128D818StartConversion(adcDevice, (schedule.mode == kIOModScheduleMode_LowPower) ? kADC128D818_ConversionRate_LowPower : kADC128D818_ConversionRate_Continuous);
+            }
+            break;
+        default:
+            // One-shot round robins are started by the scan.
+            status = ADC128D818StopConversion(adcDevice);
+            if (status == 0)
+            {
+                status = ADC128D818DeepShutdown(adcDevice, kADC128D818_RegisterDeepShutdown_DeepShutdownEnable);
+            }
+            break;
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+// Channels of a one-shot slave to read now: a round robin is started once per period, its channels are read once done.
+static int IOModOneShotProcess(uint8_t inSlaveID, uint32_t inTimestampUs, const IOModSchedule_t* inSchedule, uint8_t* outChannelMask)
+{
+    IOModOneShot_t* oneShot = &gOneShots[inSlaveID];
+    int status = 0;
+
+    *outChannelMask = 0;
+
+    if (oneShot->converting)
+    {
+        // Busy status only read once the round robin should be done.
+        if ((inTimestampUs - oneShot->triggerUs) >= inSchedule->cycleUs)
+        {
+            uint8_t busyStatus;
+            status = ADC128D818ReadBusyStatus(gADCDeviceTable[inSlaveID], &busyStatus);
+            if ((status == 0) && !(busyStatus & kADC128D818_RegisterBusyStatus_Busy))
+            {
+                oneShot->converting = false;
+                *outChannelMask = inSchedule->channelMask;
+            }
+        }
+    }
+    else if (!oneShot->triggered || ((int32_t)(inTimestampUs - oneShot->nextUs) >= 0))
+    {
+        status = ADC128D818SingleConversion(gADCDeviceTable[inSlaveID]);
+        if (status == 0)
+        {
+            // Late starts do not delay the next ones, unless a whole period late.
+            if (oneShot->triggered && ((inTimestampUs - oneShot->nextUs) < inSchedule->periodUs))
+            {
+                oneShot->nextUs += inSchedule->periodUs;
+                oneShot->periodUs = 0;
+            }
+            else
+            {
+                oneShot->periodUs = oneShot->triggered ? (inTimestampUs - oneShot->triggerUs) : 0;
+                oneShot->nextUs = inTimestampUs + inSchedule->periodUs;
+            }
+            oneShot->triggerUs = inTimestampUs;
+            oneShot->triggered = true;
+            oneShot->converting = true;
+        }
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+static void IOModPushSample(IOModSampleRing_t* inRing, uint32_t inTimestampUs, uint16_t inRawData)
+{
+    uint32_t head = inRing->head;
+    inRing->samples[head & (kIOModSampleRingSize - 1)].timestampUs = inTimestampUs;
+    inRing->samples[head & (kIOModSampleRingSize - 1)].rawData = inRawData;
+    // Publish the sample before the new head.
+    mIOModMemoryBarrier();
+    inRing->head = head + 1;
+}
+
+// ----------------------------------------------------------------------------
+static uint8_t IOModCopySamples(IOModSampleRing_t* inRing, IOModSample_t* outSamples, uint8_t inCount)
+{
+    uint8_t count;
+    uint32_t head;
+
+    do
+    {
+        head = inRing->head;
+        mIOModMemoryBarrier();
+        count = inCount;
+        if (count > head)
+        {
+            count = head;
+        }
+        if (count > kIOModSampleRingSize - 1)
+        {
+            count = kIOModSampleRingSize - 1;
+        }
+        for (uint8_t sampleIdx = 0; sampleIdx < count; sampleIdx ++)
+        {
+            outSamples[sampleIdx] = inRing->samples[(head - 1 - sampleIdx) & (kIOModSampleRingSize - 1)];
+        }
+        mIOModMemoryBarrier();
+        // Retry if the producer wrapped over the copied slots (the slot at head is the one being written).
+    } while ((inRing->head - head) > (uint32_t)(kIOModSampleRingSize - 1 - count));
+
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// A channel has a new conversion once a round robin elapsed since its latest sample.
+static bool IOModIsNewConversion(IOModSampleRing_t* inRing, uint32_t inTimestampUs, uint32_t inCycleUs)
+{
+    IOModSample_t sample;
+
+    if (IOModCopySamples(inRing, &sample, 1) == 0)
+    {
+        return true;
+    }
+
+    return (inTimestampUs - sample.timestampUs) >= inCycleUs;
+}
+
+// ----------------------------------------------------------------------------
+static int32_t IOModDecodeInternalTemperature(uint16_t inADCRawData)
+{
+    // Shift right 3 as we pass from 12 bit to 9 bit result for internal temperature.
+    inADCRawData >>= 3;
+
+    // 9-bit two's-complement conversions of the temperature (see datasheet p.28).
+    // Note: Normal conversion x 1000 to add 3 float digits to be compatible with single-ended ADC conversions (however precision is 0.5C, thus 500).
+    if (!(inADCRawData & kADC128D818_TemperatureMSBMask))
+    {
+        // If temperature is positive.
+        // If DOUT[MSb] = 0: + Temp(C) = DOUT(dec) / 2.
+        return (inADCRawData * 1000) >> 1;
+    }
+    else
+    {
+        // If temperature is negative.
+        // If DOUT[MSb] = 1: - Temp(C) = [2^9 - DOUT(dec)] / 2.
+        return -(int32_t)(((0x0200 - inADCRawData) * 1000) >> 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+static int32_t IOModDecodeCurrent(uint8_t inSlaveID, uint8_t inChannelIdx, uint16_t inADCRawData)
+{
+    return ConversionDecodeFused(inADCRawData, &gCalibrations[inSlaveID][inChannelIdx]);
+}
+
+// ----------------------------------------------------------------------------
+// Raw threshold of the channel limit through its calibration.
+static int IOModUpdateCurrentLimit(uint8_t inSlaveID, uint8_t inChannelIdx)
+{
+    IOModCurrentLimit_t* currentLimit = &gCurrentLimits[inSlaveID][inChannelIdx];
+
+    if (ConversionEncodeFused(currentLimit->limit, &gCalibrations[inSlaveID][inChannelIdx], &currentLimit->limitRaw) != 0)
+    {
+        // Limit below the calibration offset or folded conversion, always overloaded.
+        currentLimit->limitRaw = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+static void IOModUpdateChannelStats(uint8_t inSlaveID, uint8_t inChannelIdx, uint16_t inADCRawData)
+{
+    IOModChannelStats_t* channelStats = &gChannelStats[inSlaveID][inChannelIdx];
+    int32_t value;
+
+    if (channelStats->resetRequest)
+    {
+        IOModStatsReset(&channelStats->accumulator);
+        channelStats->resetRequest = false;
+    }
+
+    switch (channelStats->type)
+    {
+        case kIOModChannelType_Current:
+            value = IOModDecodeCurrent(inSlaveID, inChannelIdx, inADCRawData);
+            break;
+        case kIOModChannelType_Temperature:
+            // Out of range samples are not accounted.
+            if (USP10973ComputeTemperature(inADCRawData, &value) != 0)
+            {
+                return;
+            }
+            break;
+        default:
+            return;
+    }
+
+    IOModStatsUpdate(&channelStats->accumulator, value);
+}
+
+// ----------------------------------------------------------------------------
+static void IOModUpdateChannelFilter(uint8_t inSlaveID, uint8_t inChannelIdx, uint32_t inTimestampUs, uint16_t inADCRawData)
+{
+    IOModChannelFilter_t* channelFilter = &gChannelFilters[inSlaveID][inChannelIdx];
+    uint32_t value;
+
+    if (channelFilter->request)
+    {
+        // Validated by IOModSetChannelFilter.
+        IOModFilterInit(&channelFilter->filter, &channelFilter->requestConfig);
+        channelFilter->enabled = true;
+        channelFilter->sequence ++;
+        mIOModMemoryBarrier();
+        channelFilter->hasOutput = false;
+        mIOModMemoryBarrier();
+        channelFilter->sequence ++;
+        channelFilter->request = false;
+    }
+
+    if (!channelFilter->enabled || !IOModFilterProcess(&channelFilter->filter, inADCRawData, &value))
+    {
+        return;
+    }
+
+    channelFilter->sequence ++;
+    mIOModMemoryBarrier();
+    channelFilter->output.timestampUs = inTimestampUs;
+    channelFilter->output.value = value;
+    channelFilter->hasOutput = true;
+    mIOModMemoryBarrier();
+    channelFilter->sequence ++;
+}
+
+// ----------------------------------------------------------------------------
+// Completion of one channel reading of the asynchronous scan.
+static void IOModScanTransactionDone(IOModBusTransaction_t* inTransaction)
+{
+    uint16_t readingIdx = (uint16_t)(uintptr_t)inTransaction->context;
+    uint8_t slaveID = readingIdx / kADC128D818_MaxChannels;
+    uint8_t channelIdx = readingIdx % kADC128D818_MaxChannels;
+
+    if (inTransaction->status != 0)
+    {
+        gScanStatus = kIOModPortStatus_DriverBusError;
+    }
+    else
+    {
+        uint16_t adcRawData = ADC128D818DecodeReading(gScanReadings[readingIdx]);
+        IOModPushSample(&gSampleRings[slaveID][channelIdx], gScanTimestampUs, adcRawData);
+        IOModUpdateChannelStats(slaveID, channelIdx, adcRawData);
+        IOModUpdateChannelFilter(slaveID, channelIdx, gScanTimestampUs, adcRawData);
+    }
+
+    // Buses complete in parallel.
+    if ((__sync_sub_and_fetch(&gScanPendingCount, 1) == 0) && gScanCallback)
+    {
+        gScanCallback(gScanStatus, gScanContext);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Age from which a scanned sample is stale: the channel period (or the time between conversions without one) plus
+// one round robin for the conversion itself.
+static uint32_t IOModGetSampleMaxAgeUs(uint8_t inSlaveID, uint8_t inChannelIdx)
+{
+    IOModSchedule_t schedule;
+
+    IOModPlanSchedule(inSlaveID, &schedule);
+    uint32_t periodUs = gChannelPeriodUs[inSlaveID][inChannelIdx];
+    if (periodUs < schedule.periodUs)
+    {
+        periodUs = schedule.periodUs;
+    }
+
+    return periodUs + schedule.cycleUs;
+}
+
+// ----------------------------------------------------------------------------
+static int IOModReadRaw(uint8_t inSlaveID, uint8_t inChannelIdx, uint16_t* outADCData)
+{
+    IOModSample_t sample;
+
+    // Use the scan engine sample when there is a recent one, the slave is read once the scan stopped.
+    if ((IOModGetLatestSample(inSlaveID, inChannelIdx, &sample) == kIOModPortStatus_Valid) &&
+        ((mIOModGetTimeUs() - sample.timestampUs) <= IOModGetSampleMaxAgeUs(inSlaveID, inChannelIdx)))
+    {
+        *outADCData = sample.rawData;
+        return 0;
+    }
+
+    return ADC128D818ReadChannel(gADCDeviceTable[inSlaveID], inChannelIdx, outADCData);
+}
 
 // ----------------------------------------------------------------------------
 uint8_t IOModGetADCAddress(uint8_t inSlaveID)
 {
-    // Set local devices addresses.
+    // Set local devices addresses, the same on each bus.
     uint8_t adcAddress;
-    switch (inSlaveID)
+    switch ((inSlaveID < kIOModMaxSlaves) ? (inSlaveID % kADC128D818_MaxAddresses) : 0xFF)
     {
         case 0:
             adcAddress = kADC128D818_SlaveAddress1;
@@ -76,15 +604,122 @@ uint8_t IOModGetADCAddress(uint8_t inSlaveID)
     return adcAddress;
 }
 
+// ----------------------------------------------------------------------------
+uint16_t IOModGetADCDevice(uint8_t inSlaveID)
+{
+    return mIOModBusDevice(inSlaveID / kADC128D818_MaxAddresses, IOModGetADCAddress(inSlaveID));
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModDiscover(void)
+{
+    bool present = false;
+
+    // Buses are used by the asynchronous scan.
+    if (gScanPendingCount != 0)
+    {
+        return kIOModPortStatus_Pending;
+    }
+    // Probes of a timed out discovery still queued, they can not be submitted again.
+    for (uint8_t slaveID = 0; gDiscoveryDone && (slaveID < kIOModMaxSlaves); slaveID ++)
+    {
+        if (!gDiscoveryTransactions[slaveID].done && !IOModBusIdle(slaveID / kADC128D818_MaxAddresses))
+        {
+            return kIOModPortStatus_Pending;
+        }
+    }
+
+    // One manufacturer ID read per slave, absent slaves only cost an address NACK.
+    for (uint8_t slaveID = 0; slaveID < kIOModMaxSlaves; slaveID ++)
+    {
+        IOModBusTransaction_t* transaction = &gDiscoveryTransactions[slaveID];
+        gDiscoveryIDs[slaveID] = 0;
+        transaction->operation = kIOModBusOperation_ReadRegister;
+        transaction->device = IOModGetADCDevice(slaveID);
+        transaction->reg = kADC128D818_RegisterManufacturerID;
+        transaction->data = &gDiscoveryIDs[slaveID];
+        transaction->size = 1;
+        transaction->callback = NULL;
+        transaction->context = NULL;
+    }
+    IOModBusSubmitBatch(gDiscoveryTransactions, kIOModMaxSlaves);
+
+    // Interrupt driven buses probe in parallel, polled buses one after the other.
+    for (uint8_t busID = 0; busID < kIOModBusMax; busID ++)
+    {
+        IOModBusProcess(busID);
+        gADCPresentMask[busID] = 0;
+    }
+
+    // Slaves not answered by the deadline (ex: lost completion interrupt) are absent.
+    uint32_t startUs = mIOModGetTimeUs();
+    for (uint8_t slaveID = 0; slaveID < kIOModMaxSlaves; slaveID ++)
+    {
+        while (!gDiscoveryTransactions[slaveID].done && ((mIOModGetTimeUs() - startUs) < kIOModDiscoverTimeoutUs))
+        {
+            IOModBusProcess(slaveID / kADC128D818_MaxAddresses);
+        }
+
+        if ((gDiscoveryTransactions[slaveID].status == 0) && (gDiscoveryIDs[slaveID] == kADC128D818_ManufacturerID))
+        {
+            gADCPresentMask[slaveID / kADC128D818_MaxAddresses] |= (1 << (slaveID % kADC128D818_MaxAddresses));
+            present = true;
+        }
+    }
+    // Absent slaves leave the scan until initialized again.
+    for (uint8_t busID = 0; busID < kIOModBusMax; busID ++)
+    {
+        gADCInitializedMask[busID] &= gADCPresentMask[busID];
+    }
+    gDiscoveryDone = true;
+
+    return present ? kIOModPortStatus_Valid : kIOModPortStatus_NotDetected;
+}
+
+// ----------------------------------------------------------------------------
+bool IOModIsPresent(uint8_t inSlaveID)
+{
+    if (inSlaveID >= kIOModMaxSlaves)
+    {
+        return false;
+    }
+
+    // Unknown until discovery.
+    if (!gDiscoveryDone)
+    {
+        return true;
+    }
+
+    return (gADCPresentMask[inSlaveID / kADC128D818_MaxAddresses] & (1 << (inSlaveID % kADC128D818_MaxAddresses))) != 0;
+}
+
 // ----------------------------------------------------------------------------
 IOModPortStatus_e IOModADCInit(uint8_t inSlaveID)
 {
-    // Get the slave ADC address.
-    gADCI2CAddressTable[inSlaveID] = IOModGetADCAddress(inSlaveID);
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    // Do not wait for the busy timeout of an empty slot.
+    mIOModValidatePresent(inSlaveID);
+
+    // Get the slave ADC bus and address.
+    gADCDeviceTable[inSlaveID] = IOModGetADCDevice(inSlaveID);
     // Initialize ADC.
-    mIOModValidateDriverStatus(ADC128D818Init(gADCI2CAddressTable[inSlaveID]));
-    // Start ADC continuous conversions.
-    mIOModValidateDriverStatus(ADC128D818StartConversion(gADCI2CAddressTable[inSlaveID], kADC128D818_ConversionRate_Continuous));
+    mIOModValidateDriverStatus(ADC128D818Init(gADCDeviceTable[inSlaveID]));
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if (!(gCalibrationMask[inSlaveID] & (1 << channelIdx)))
+        {
+            gCalibrations[inSlaveID][channelIdx] = kIOModCurrentConversion;
+        }
+        if (!(gCurrentLimitMask[inSlaveID] & (1 << channelIdx)))
+        {
+            gCurrentLimits[inSlaveID][channelIdx].limit = kIOModCurrentLimitDefault;
+        }
+        IOModUpdateCurrentLimit(inSlaveID, channelIdx);
+    }
+    // Start ADC conversions, continuous unless the channel periods allow less.
+    mIOModValidateDriverStatus(IOModApplySchedule(inSlaveID));
+    gADCInitializedMask[inSlaveID / kADC128D818_MaxAddresses] |= (1 << (inSlaveID % kADC128D818_MaxAddresses));
 
     // If we make it this far, its a success.
     return 0;
@@ -97,10 +732,12 @@ IOModPortStatus_e IOModGetTemperature(uint8_t inSlaveID, uint8_t inChannelIdx, i
     int32_t temperature = 0;
     uint16_t adcRawData;
 
-    mIOModValidateDriverStatus(ADC128D818ReadChannel(gADCI2CAddressTable[inSlaveID], inChannelIdx, &adcRawData));
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateChannelEnabled(inSlaveID, inChannelIdx);
+    mIOModValidateDriverStatus(IOModReadRaw(inSlaveID, inChannelIdx, &adcRawData));
 
     // Convert thermistor value.
-    if (USP10973BetaComputeTemperature(adcRawData, &temperature) != 0)
+    if (USP10973ComputeTemperature(adcRawData, &temperature) != 0)
     {
         status = kIOModPortStatus_InvalidRange;
     }
@@ -117,58 +754,762 @@ IOModPortStatus_e IOModGetTemperature(uint8_t inSlaveID, uint8_t inChannelIdx, i
 // ----------------------------------------------------------------------------
 IOModPortStatus_e IOModGetInternalTemperature(uint8_t inSlaveID, int32_t* outADCData)
 {
-    uint16_t adcRawData;
+    mIOModValidatePresent(inSlaveID);
 
-    mIOModValidateDriverStatus(ADC128D818SetMode(gADCI2CAddressTable[inSlaveID], kADC128D818_Mode_Temp));
-    // TODO: Wait for conversion switch to stabilize.
-    DelayUs(30000);
-    mIOModValidateDriverStatus(ADC128D818ReadChannel(gADCI2CAddressTable[inSlaveID], kADC128D818_RegisterChannel7Read, &adcRawData));
-    // TODO: Should put back in the config mode it was instead of forcing back single ended.
-    mIOModValidateDriverStatus(ADC128D818SetMode(gADCI2CAddressTable[inSlaveID], kADC128D818_Mode_SingleEnded));
+    IOModInternalTemperature_t* internalTemperature = &gInternalTemperature[inSlaveID];
+    IOModSchedule_t schedule;
+    IOModPlanSchedule(inSlaveID, &schedule);
 
-    // Shift right 3 as we pass from 12 bit to 9 bit result for internal temperature.
-    adcRawData >>= 3;
+    // Use the scan engine value when there is a recent one: acquired within a period, its settling and one round
+    // robin for the scan visit. The slave is read once the scan stopped.
+    if (internalTemperature->periodUs && internalTemperature->hasValue &&
+        ((mIOModGetTimeUs() - internalTemperature->lastUs) <= (internalTemperature->periodUs + kIOModInternalTemperatureSettleUs + schedule.cycleUs)))
+    {
+        *outADCData = internalTemperature->value;
+        return kIOModPortStatus_Valid;
+    }
 
-    // 9-bit two's-complement conversions of the temperature (see datasheet p.28).
-    // Note: Normal conversion x 1000 to add 3 float digits to be compatible with single-ended ADC conversions (however precision is 0.5C, thus 500).
-    if (!(adcRawData & kADC128D818_TemperatureMSBMask))
+    // kIOModPortStatus_Pending while an acquisition of the scan engine or IOModInternalTemperatureStart is settling,
+    // it owns the mode to restore.
+    uint32_t startUs = mIOModGetTimeUs();
+    IOModPortStatus_e status = IOModInternalTemperatureStart(inSlaveID, startUs);
+    if (status == kIOModPortStatus_Valid)
     {
-        // If temperature is positive.
-        // If DOUT[MSb] = 0: + Temp(�C) = DOUT(dec) / 2.
-        *outADCData = (adcRawData * 1000) >> 1;
+        // Wait for conversion switch to stabilize. The restore is then left to settle, the scan skips IN7 meanwhile.
+        DelayUs(kIOModInternalTemperatureSettleUs);
+        status = IOModInternalTemperaturePoll(inSlaveID, mIOModGetTimeUs(), outADCData);
     }
-    else
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModInternalTemperatureStart(uint8_t inSlaveID, uint32_t inTimestampUs)
+{
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateInitialized(inSlaveID);
+    // The temperature is converted in place of IN7.
+    mIOModValidateChannelEnabled(inSlaveID, kADC128D818_IN7);
+
+    IOModInternalTemperature_t* internalTemperature = &gInternalTemperature[inSlaveID];
+
+    if (internalTemperature->state == kIOModInternalTemperatureState_Settling)
     {
-        // If temperature is negative.
-        // If DOUT[MSb] = 1: � Temp(�C) = [29 � DOUT(dec)] / 2 .
-        *outADCData = -(int32_t)(((0x0200 - adcRawData) * 1000) >> 1);
+        return kIOModPortStatus_Pending;
     }
 
-    // If we make it this far, its a success.
-    return 0;
+    // Keep the mode to restore.
+    mIOModValidateDriverStatus(ADC128D818GetMode(gADCDeviceTable[inSlaveID], &internalTemperature->previousMode));
+    mIOModValidateDriverStatus(ADC128D818SetMode(gADCDeviceTable[inSlaveID], kADC128D818_Mode_Temp));
+    internalTemperature->startUs = inTimestampUs;
+    internalTemperature->state = kIOModInternalTemperatureState_Settling;
+
+    return kIOModPortStatus_Valid;
 }
 
 // ----------------------------------------------------------------------------
-IOModPortStatus_e IOModGetCurrent(uint8_t inSlaveID, uint8_t inChannelIdx, int32_t* outADCData)
+IOModPortStatus_e IOModInternalTemperaturePoll(uint8_t inSlaveID, uint32_t inTimestampUs, int32_t* outADCData)
 {
-    int status;
-    int32_t current = 0;
     uint16_t adcRawData;
 
-    mIOModValidateDriverStatus(ADC128D818ReadChannel(gADCI2CAddressTable[inSlaveID], inChannelIdx, &adcRawData));
+    mIOModValidatePresent(inSlaveID);
 
-    // Convert to mA: (300 / 2^12 - 1) * 2^16.
-    current = ConversionDecode(adcRawData, 4801, 16, 1);
+    IOModInternalTemperature_t* internalTemperature = &gInternalTemperature[inSlaveID];
 
-    // TODO: Make constants (should also be programmable).
-    if (current > 300)
+    if (internalTemperature->state != kIOModInternalTemperatureState_Settling)
     {
-        status = kIOModPortStatus_OverLoad;
+        return kIOModPortStatus_InvalidRange;
     }
-    else
+
+    if ((inTimestampUs - internalTemperature->startUs) < kIOModInternalTemperatureSettleUs)
     {
-        status = kIOModPortStatus_Valid;
-        *outADCData = current;
+        return kIOModPortStatus_Pending;
+    }
+
+    int readStatus = ADC128D818ReadChannel(gADCDeviceTable[inSlaveID], kADC128D818_RegisterChannel7Read, &adcRawData);
+    // Always try to put back the previous mode.
+    int restoreStatus = ADC128D818SetMode(gADCDeviceTable[inSlaveID], internalTemperature->previousMode);
+    internalTemperature->startUs = inTimestampUs;
+    internalTemperature->state = kIOModInternalTemperatureState_Restoring;
+    mIOModValidateDriverStatus(readStatus);
+    mIOModValidateDriverStatus(restoreStatus);
+
+    *outADCData = IOModDecodeInternalTemperature(adcRawData);
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+void IOModScanInternalTemperature(uint8_t inSlaveID, uint32_t inPeriodUs)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    gInternalTemperature[inSlaveID].periodUs = inPeriodUs;
+    gInternalTemperature[inSlaveID].hasValue = false;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModGetCurrent(uint8_t inSlaveID, uint8_t inChannelIdx, int32_t* outADCData)
+{
+    uint16_t adcRawData;
+
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateChannelEnabled(inSlaveID, inChannelIdx);
+    mIOModValidateDriverStatus(IOModReadRaw(inSlaveID, inChannelIdx, &adcRawData));
+
+    // Same as comparing the converted value with the limit.
+    if (adcRawData > gCurrentLimits[inSlaveID][inChannelIdx].limitRaw)
+    {
+        return kIOModPortStatus_OverLoad;
+    }
+
+    *outADCData = IOModDecodeCurrent(inSlaveID, inChannelIdx, adcRawData);
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModSetCurrentLimit(uint8_t inSlaveID, uint8_t inChannelIdx, int32_t inLimit)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    if ((inLimit < 0) || (inLimit > UINT16_MAX))
+    {
+        return kIOModPortStatus_InvalidRange;
+    }
+
+    gCurrentLimits[inSlaveID][inChannelIdx].limit = (uint16_t)inLimit;
+    gCurrentLimitMask[inSlaveID] |= (1 << inChannelIdx);
+
+    // Done by IOModADCInit otherwise, with the calibration.
+    if (mIOModIsInitialized(inSlaveID) && (IOModUpdateCurrentLimit(inSlaveID, inChannelIdx) != 0))
+    {
+        return kIOModPortStatus_InvalidRange;
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModSetChannelCalibration(uint8_t inSlaveID, uint8_t inChannelIdx, const ConversionCalibration_t* inCalibration)
+{
+    ConversionFused_t fused = kIOModCurrentConversion;
+
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    if (inCalibration->encode.multiplier == 0)
+    {
+        gCalibrationMask[inSlaveID] &= ~(1 << inChannelIdx);
+    }
+    else
+    {
+        if (ConversionFuse(inCalibration, &fused) != 0)
+        {
+            return kIOModPortStatus_InvalidRange;
+        }
+        gCalibrationMask[inSlaveID] |= (1 << inChannelIdx);
+    }
+    gCalibrations[inSlaveID][inChannelIdx] = fused;
+
+    // The raw threshold follows the calibration.
+    if (mIOModIsInitialized(inSlaveID) && (IOModUpdateCurrentLimit(inSlaveID, inChannelIdx) != 0))
+    {
+        return kIOModPortStatus_InvalidRange;
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModLoadCalibrations(uint32_t inAddress)
+{
+    IOModPortStatus_e status = kIOModPortStatus_Valid;
+
+    // One entry at a time, the whole table does not fit the stack of small tasks. Entries are in channels order.
+    uint32_t address = inAddress;
+    for (uint8_t slaveID = 0; slaveID < kIOModMaxSlaves; slaveID ++)
+    {
+        for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+        {
+            ConversionCalibration_t calibration;
+            IOModPortStatus_e channelStatus = kIOModPortStatus_DriverBusError;
+
+            if (BoardConfig_Read(address, (uint8_t*)&calibration, sizeof(calibration)) == 0)
+            {
+                channelStatus = IOModSetChannelCalibration(slaveID, channelIdx, &calibration);
+            }
+            address += sizeof(calibration);
+
+            // Apply to all channels, report the first error.
+            if (status == kIOModPortStatus_Valid)
+            {
+                status = channelStatus;
+            }
+        }
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModCheckCurrent(uint8_t inSlaveID, uint8_t inChannelIdx)
+{
+    uint16_t adcRawData;
+
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateChannelEnabled(inSlaveID, inChannelIdx);
+    mIOModValidateDriverStatus(IOModReadRaw(inSlaveID, inChannelIdx, &adcRawData));
+
+    if (adcRawData > gCurrentLimits[inSlaveID][inChannelIdx].limitRaw)
+    {
+        return kIOModPortStatus_OverLoad;
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModScanProcess(uint32_t inTimestampUs)
+{
+    IOModPortStatus_e status = kIOModPortStatus_NotDetected;
+
+    for (uint8_t busID = 0; busID < kIOModBusMax; busID ++)
+    {
+        IOModPortStatus_e busStatus = IOModScanProcessBus(busID, inTimestampUs);
+        // Report errors first, then success of any bus.
+        if ((busStatus != kIOModPortStatus_NotDetected) && (status == kIOModPortStatus_NotDetected || status == kIOModPortStatus_Valid))
+        {
+            status = busStatus;
+        }
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModScanProcessBus(uint8_t inBusID, uint32_t inTimestampUs)
+{
+    uint16_t adcRawData[kADC128D818_MaxChannels];
+
+    mIOAssertArg(inBusID < kIOModBusMax);
+
+    if (gADCInitializedMask[inBusID] == 0)
+    {
+        return kIOModPortStatus_NotDetected;
+    }
+
+    // Next initialized slave of the bus.
+    do
+    {
+        gScanSlaveID[inBusID] = (gScanSlaveID[inBusID] + 1) % kADC128D818_MaxAddresses;
+    } while (!(gADCInitializedMask[inBusID] & (1 << gScanSlaveID[inBusID])));
+    uint8_t slaveID = inBusID * kADC128D818_MaxAddresses + gScanSlaveID[inBusID];
+
+    // IN7 holds a temperature conversion around internal temperature acquisitions.
+    IOModInternalTemperature_t* internalTemperature = &gInternalTemperature[slaveID];
+    if ((internalTemperature->state == kIOModInternalTemperatureState_Restoring) && ((inTimestampUs - internalTemperature->startUs) >= kIOModInternalTemperatureSettleUs))
+    {
+        internalTemperature->state = kIOModInternalTemperatureState_Idle;
+    }
+    IOModSchedule_t schedule;
+    IOModPlanSchedule(slaveID, &schedule);
+    uint8_t channelMask = schedule.channelMask;
+    if (internalTemperature->state != kIOModInternalTemperatureState_Idle)
+    {
+        channelMask &= ~(1 << kADC128D818_IN7);
+    }
+
+    if (schedule.mode == kIOModScheduleMode_OneShot)
+    {
+        uint8_t doneMask;
+        mIOModValidateDriverStatus(IOModOneShotProcess(slaveID, inTimestampUs, &schedule, &doneMask));
+        channelMask &= doneMask;
+    }
+    else
+    {
+        // Do not read again channels without a new conversion.
+        for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+        {
+            if ((channelMask & (1 << channelIdx)) && !IOModIsNewConversion(&gSampleRings[slaveID][channelIdx], inTimestampUs, schedule.periodUs))
+            {
+                channelMask &= ~(1 << channelIdx);
+            }
+        }
+    }
+
+    mIOModValidateDriverStatus(ADC128D818ReadAllChannels(gADCDeviceTable[slaveID], channelMask, adcRawData));
+
+    for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+    {
+        if (channelMask & (1 << channelIdx))
+        {
+            IOModPushSample(&gSampleRings[slaveID][channelIdx], inTimestampUs, adcRawData[channelIdx]);
+            IOModUpdateChannelStats(slaveID, channelIdx, adcRawData[channelIdx]);
+            IOModUpdateChannelFilter(slaveID, channelIdx, inTimestampUs, adcRawData[channelIdx]);
+        }
+    }
+
+    // Internal temperature acquisition, mode switches happen at most once per period.
+    if (internalTemperature->periodUs)
+    {
+        if ((internalTemperature->state == kIOModInternalTemperatureState_Idle) && (!internalTemperature->hasValue || ((inTimestampUs - internalTemperature->lastUs) >= internalTemperature->periodUs)))
+        {
+            IOModPortStatus_e status = IOModInternalTemperatureStart(slaveID, inTimestampUs);
+            if (status != kIOModPortStatus_Valid)
+            {
+                return status;
+            }
+        }
+        else if (internalTemperature->state == kIOModInternalTemperatureState_Settling)
+        {
+            int32_t temperature;
+            IOModPortStatus_e status = IOModInternalTemperaturePoll(slaveID, inTimestampUs, &temperature);
+            if (status == kIOModPortStatus_Valid)
+            {
+                internalTemperature->value = temperature;
+                internalTemperature->lastUs = inTimestampUs;
+                internalTemperature->hasValue = true;
+            }
+            else if (status != kIOModPortStatus_Pending)
+            {
+                return status;
+            }
+        }
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModGetLatestSample(uint8_t inSlaveID, uint8_t inChannelIdx, IOModSample_t* outSample)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    if (IOModCopySamples(&gSampleRings[inSlaveID][inChannelIdx], outSample, 1) == 0)
+    {
+        return kIOModPortStatus_NotDetected;
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+uint8_t IOModGetSampleHistory(uint8_t inSlaveID, uint8_t inChannelIdx, IOModSample_t* outSamples, uint8_t inCount)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    return IOModCopySamples(&gSampleRings[inSlaveID][inChannelIdx], outSamples, inCount);
+}
+
+// ----------------------------------------------------------------------------
+void IOModSetChannelType(uint8_t inSlaveID, uint8_t inChannelIdx, IOModChannelType_e inType)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels && inType < kIOModChannelType_Max);
+
+    gChannelStats[inSlaveID][inChannelIdx].type = inType;
+    gChannelStats[inSlaveID][inChannelIdx].resetRequest = true;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModGetChannelStats(uint8_t inSlaveID, uint8_t inChannelIdx, IOModStats_t* outStats)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    IOModChannelStats_t* channelStats = &gChannelStats[inSlaveID][inChannelIdx];
+    if (channelStats->resetRequest)
+    {
+        outStats->count = 0;
+        return kIOModPortStatus_NotDetected;
+    }
+
+    IOModStatsSnapshot(&channelStats->accumulator, outStats);
+    if (outStats->count == 0)
+    {
+        return kIOModPortStatus_NotDetected;
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+void IOModResetChannelStats(uint8_t inSlaveID, uint8_t inChannelIdx)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    gChannelStats[inSlaveID][inChannelIdx].resetRequest = true;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModSetChannelFilter(uint8_t inSlaveID, uint8_t inChannelIdx, const IOModFilterConfig_t* inConfig)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    IOModChannelFilter_t* channelFilter = &gChannelFilters[inSlaveID][inChannelIdx];
+    IOModFilter_t filter;
+
+    if (IOModFilterInit(&filter, inConfig) != 0)
+    {
+        return kIOModPortStatus_InvalidRange;
+    }
+
+    // One request at a time, the scan engine applies it on the next sample.
+    if (channelFilter->request)
+    {
+        return kIOModPortStatus_Pending;
+    }
+    channelFilter->requestConfig = *inConfig;
+    mIOModMemoryBarrier();
+    channelFilter->request = true;
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModGetFiltered(uint8_t inSlaveID, uint8_t inChannelIdx, IOModFilteredSample_t* outSample)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    IOModChannelFilter_t* channelFilter = &gChannelFilters[inSlaveID][inChannelIdx];
+    uint32_t sequence;
+    bool hasOutput;
+
+    do
+    {
+        sequence = channelFilter->sequence;
+        mIOModMemoryBarrier();
+        hasOutput = channelFilter->hasOutput;
+        *outSample = channelFilter->output;
+        mIOModMemoryBarrier();
+    } while ((sequence & 1) || (sequence != channelFilter->sequence));
+
+    // No output since the filter was set.
+    if (!hasOutput)
+    {
+        return kIOModPortStatus_NotDetected;
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModScanSubmit(uint32_t inTimestampUs, IOModScanCallback_t inCallback, void* inContext)
+{
+    uint16_t transactionCount = 0;
+    bool noNewConversion = false;
+    bool busError = false;
+
+    if (gScanPendingCount != 0)
+    {
+        return kIOModPortStatus_Pending;
+    }
+
+    gScanTimestampUs = inTimestampUs;
+    gScanStatus = kIOModPortStatus_Valid;
+    gScanCallback = inCallback;
+    gScanContext = inContext;
+
+    for (uint8_t slaveID = 0; slaveID < kIOModMaxSlaves; slaveID ++)
+    {
+        if (!mIOModIsInitialized(slaveID))
+        {
+            continue;
+        }
+
+        IOModSchedule_t schedule;
+        IOModPlanSchedule(slaveID, &schedule);
+        uint8_t channelMask = schedule.channelMask;
+
+        if (schedule.mode == kIOModScheduleMode_OneShot)
+        {
+            // Retried by the next scan on bus errors (trigger or busy status read), reported through the batch status.
+            if (IOModOneShotProcess(slaveID, inTimestampUs, &schedule, &channelMask) != 0)
+            {
+                busError = true;
+                continue;
+            }
+            // Started or not done yet.
+            if (channelMask == 0)
+            {
+                noNewConversion = true;
+                continue;
+            }
+        }
+
+        for (uint8_t channelIdx = 0; channelIdx < kADC128D818_MaxChannels; channelIdx ++)
+        {
+            if (!(channelMask & (1 << channelIdx)))
+            {
+                continue;
+            }
+
+            // IN7 holds a temperature conversion around internal temperature acquisitions.
+            if ((channelIdx == kADC128D818_IN7) && (gInternalTemperature[slaveID].state != kIOModInternalTemperatureState_Idle))
+            {
+                continue;
+            }
+
+            // Completions of the previous batch are done, its samples are in the rings.
+            if ((schedule.mode != kIOModScheduleMode_OneShot) && !IOModIsNewConversion(&gSampleRings[slaveID][channelIdx], inTimestampUs, schedule.periodUs))
+            {
+                noNewConversion = true;
+                continue;
+            }
+
+            uint16_t readingIdx = slaveID * kADC128D818_MaxChannels + channelIdx;
+            IOModBusTransaction_t* transaction = &gScanTransactions[transactionCount];
+            transaction->operation = kIOModBusOperation_ReadRegister;
+            transaction->device = gADCDeviceTable[slaveID];
+            transaction->reg = kADC128D818_RegisterChannel0Read + channelIdx;
+            transaction->data = gScanReadings[readingIdx];
+            transaction->size = 2;
+            transaction->callback = IOModScanTransactionDone;
+            transaction->context = (void*)(uintptr_t)readingIdx;
+            transactionCount ++;
+        }
+    }
+
+    if (busError)
+    {
+        gScanStatus = kIOModPortStatus_DriverBusError;
+    }
+
+    if (transactionCount == 0)
+    {
+        if (busError)
+        {
+            return kIOModPortStatus_DriverBusError;
+        }
+        return noNewConversion ? kIOModPortStatus_Pending : kIOModPortStatus_NotDetected;
+    }
+
+    // Completions can run before IOModBusSubmitBatch returns. Each bus gets its part of the batch.
+    gScanPendingCount = transactionCount;
+    IOModBusSubmitBatch(gScanTransactions, transactionCount);
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModSetChannelMask(uint8_t inSlaveID, uint8_t inChannelMask)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    gChannelDisableMask[inSlaveID] = (uint8_t)~inChannelMask;
+
+    if (mIOModIsInitialized(inSlaveID))
+    {
+        mIOModValidateDriverStatus(IOModApplySchedule(inSlaveID));
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+uint8_t IOModGetChannelMask(uint8_t inSlaveID)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    return (uint8_t)~gChannelDisableMask[inSlaveID];
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModLoadChannelMasks(uint32_t inAddress)
+{
+    IOModChannelMasks_t channelMasks;
+    IOModPortStatus_e status = kIOModPortStatus_Valid;
+
+    if (BoardConfig_Read(inAddress, (uint8_t*)&channelMasks, sizeof(channelMasks)) != 0)
+    {
+        return kIOModPortStatus_DriverBusError;
+    }
+
+    for (uint8_t slaveID = 0; slaveID < kIOModMaxSlaves; slaveID ++)
+    {
+        // Apply to all slaves, report the first error.
+        IOModPortStatus_e slaveStatus = IOModSetChannelMask(slaveID, (uint8_t)~channelMasks.disableMask[slaveID]);
+        if (status == kIOModPortStatus_Valid)
+        {
+            status = slaveStatus;
+        }
+    }
+
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+uint32_t IOModGetConversionCycleUs(uint8_t inSlaveID)
+{
+    IOModSchedule_t schedule;
+
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    IOModPlanSchedule(inSlaveID, &schedule);
+
+    return schedule.periodUs;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModSetChannelPeriod(uint8_t inSlaveID, uint8_t inChannelIdx, uint32_t inPeriodUs)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    gChannelPeriodUs[inSlaveID][inChannelIdx] = inPeriodUs;
+    if (inPeriodUs != 0)
+    {
+        gChannelPeriodMask[inSlaveID] |= (1 << inChannelIdx);
+    }
+    else
+    {
+        gChannelPeriodMask[inSlaveID] &= ~(1 << inChannelIdx);
+    }
+
+    if (mIOModIsInitialized(inSlaveID))
+    {
+        mIOModValidateDriverStatus(IOModApplySchedule(inSlaveID));
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModGetSchedule(uint8_t inSlaveID, IOModSchedule_t* outSchedule)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    mIOModValidatePresent(inSlaveID);
+
+    IOModPlanSchedule(inSlaveID, outSchedule);
+
+    // Scan visits of the slave too far apart stretch the one-shot period.
+    uint32_t measuredUs = gOneShots[inSlaveID].periodUs;
+    if ((outSchedule->mode == kIOModScheduleMode_OneShot) && (measuredUs > outSchedule->periodUs))
+    {
+        IOModSetSchedulePeriod(inSlaveID, outSchedule, measuredUs);
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModReadIfNew(uint8_t inSlaveID, uint8_t inChannelIdx, uint32_t inTimestampUs, IOModSample_t* outSample)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateChannelEnabled(inSlaveID, inChannelIdx);
+
+    uint32_t* readUs = &gReadIfNewUs[inSlaveID][inChannelIdx];
+    bool hasRead = (gReadIfNewMask[inSlaveID] & (1 << inChannelIdx)) != 0;
+    if (hasRead && ((inTimestampUs - *readUs) < IOModGetConversionCycleUs(inSlaveID)))
+    {
+        return kIOModPortStatus_Pending;
+    }
+
+    // A scanned sample newer than the previous read costs no bus access. On the first read of the channel, a sample
+    // too old for IOModReadRaw is taken as read instead: no new conversion is known yet.
+    IOModSample_t sample;
+    bool hasSample = (IOModGetLatestSample(inSlaveID, inChannelIdx, &sample) == kIOModPortStatus_Valid);
+    if (hasSample && !hasRead && ((inTimestampUs - sample.timestampUs) > IOModGetSampleMaxAgeUs(inSlaveID, inChannelIdx)))
+    {
+        *readUs = sample.timestampUs;
+        gReadIfNewMask[inSlaveID] |= (1 << inChannelIdx);
+        return kIOModPortStatus_Pending;
+    }
+    if (hasSample && (!hasRead || ((int32_t)(sample.timestampUs - *readUs) > 0)))
+    {
+        *outSample = sample;
+    }
+    else
+    {
+        mIOModValidateDriverStatus(ADC128D818ReadChannel(gADCDeviceTable[inSlaveID], inChannelIdx, &outSample->rawData));
+        outSample->timestampUs = inTimestampUs;
+    }
+
+    *readUs = outSample->timestampUs;
+    gReadIfNewMask[inSlaveID] |= (1 << inChannelIdx);
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModSetChannelLimits(uint8_t inSlaveID, uint8_t inChannelIdx, uint16_t inLowRawData, uint16_t inHighRawData)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves && inChannelIdx < kADC128D818_MaxChannels);
+
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateInitialized(inSlaveID);
+    if (inLowRawData > inHighRawData)
+    {
+        return kIOModPortStatus_InvalidRange;
+    }
+
+    mIOModValidateDriverStatus(ADC128D818SetLimits(gADCDeviceTable[inSlaveID], inChannelIdx, inLowRawData, inHighRawData));
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModEnableAlerts(uint8_t inSlaveID, uint8_t inChannelMask)
+{
+    mIOAssertArg(inSlaveID < kIOModMaxSlaves);
+
+    mIOModValidatePresent(inSlaveID);
+    mIOModValidateInitialized(inSlaveID);
+    mIOModValidateDriverStatus(ADC128D818EnableInterrupts(gADCDeviceTable[inSlaveID], inChannelMask));
+
+    if (inChannelMask != 0)
+    {
+        gADCAlertMask[inSlaveID / kADC128D818_MaxAddresses] |= (1 << (inSlaveID % kADC128D818_MaxAddresses));
+    }
+    else
+    {
+        gADCAlertMask[inSlaveID / kADC128D818_MaxAddresses] &= ~(1 << (inSlaveID % kADC128D818_MaxAddresses));
+    }
+
+    return kIOModPortStatus_Valid;
+}
+
+// ----------------------------------------------------------------------------
+void IOModSetAlertCallback(IOModAlertCallback_t inCallback, void* inContext)
+{
+    gAlertCallback = inCallback;
+    gAlertContext = inContext;
+}
+
+// ----------------------------------------------------------------------------
+IOModPortStatus_e IOModHandleAlert(uint8_t inBusID)
+{
+    IOModPortStatus_e status = kIOModPortStatus_NotDetected;
+
+    mIOAssertArg(inBusID < kIOModBusMax);
+
+    for (uint8_t busSlaveIdx = 0; busSlaveIdx < kADC128D818_MaxAddresses; busSlaveIdx ++)
+    {
+        if (!(gADCAlertMask[inBusID] & (1 << busSlaveIdx)))
+        {
+            continue;
+        }
+
+        uint8_t slaveID = inBusID * kADC128D818_MaxAddresses + busSlaveIdx;
+        uint8_t interruptStatus;
+        // Other slaves of the bus can still hold INT.
+        if (ADC128D818ReadInterruptStatus(gADCDeviceTable[slaveID], &interruptStatus) != 0)
+        {
+            status = kIOModPortStatus_DriverBusError;
+            continue;
+        }
+
+        if (interruptStatus != 0)
+        {
+            if (status == kIOModPortStatus_NotDetected)
+            {
+                status = kIOModPortStatus_Valid;
+            }
+            if (gAlertCallback)
+            {
+                gAlertCallback(slaveID, interruptStatus, gAlertContext);
+            }
+        }
     }
 
     return status;
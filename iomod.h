@@ -20,24 +20,95 @@
 #define IOMOD_H_
 
 // Standard includes.
+#include <stdbool.h>
 #include <stdint.h>
 
+// Lib includes.
+#include "iomodstats.h"
+#include "iomodfilter.h"
+#include "iomodbus.h"
+#include "conversion.h"
+
 // ----------------------------------------------------------------------------
 // Constants
 // ----------------------------------------------------------------------------
+// Samples kept per channel by the scan engine, power of 2.
+#ifndef kIOModSampleRingSize
+#define kIOModSampleRingSize 4
+#endif
+
+// Time in us, on the clock of the scan timestamps, used by the getters to age the scanned samples (see
+// IOModScanProcess). GetTimeUs is provided by the project utils.h.
+#ifndef mIOModGetTimeUs
+#define mIOModGetTimeUs() GetTimeUs()
+#endif
+
+// Slaves 0 to 8 are on bus 0, 9 to 17 on bus 1, etc.
+#define kIOModSlavesPerBus 9
+#define kIOModMaxSlaves (kIOModSlavesPerBus * kIOModBusMax)
+#define kIOModChannelsPerSlave 8
+
+// Time for the ADC to settle after switching to / from temperature mode.
+#define kIOModInternalTemperatureSettleUs 30000
+
+// IOModDiscover wait for the probes of all buses, slaves not answered by then are absent.
+#ifndef kIOModDiscoverTimeoutUs
+#define kIOModDiscoverTimeoutUs 100000
+#endif
+
+// IOModGetCurrent overload limit (mA) of the channels without IOModSetCurrentLimit.
+#ifndef kIOModCurrentLimitDefault
+#define kIOModCurrentLimitDefault 300
+#endif
+
+// Channel periods (see IOModSetChannelPeriod) from which a slave converts one-shot then deep shutdown, twice the
+// ADC128D818 low power cycle. Low power mode below, down to one cycle (728 ms), then continuous mode. Lower values
+// trade ADC power for conversions started by the scan, which then has to visit the slave more often than the period.
+#ifndef kIOModOneShotPeriodMinUs
+#define kIOModOneShotPeriodMinUs 1456000
+#endif
+
 // Status codes.
 typedef enum
 {
     kIOModPortStatus_Valid,
-    kIOModPortStatus_NotDetected, // TODO
+    kIOModPortStatus_NotDetected,
     kIOModPortStatus_DriverBusError,
     kIOModPortStatus_InvalidRange,
     kIOModPortStatus_OverLoad,
     kIOModPortStatus_OpenLoad, // TODO
+    kIOModPortStatus_Pending,
     // Reserved for future use, keep last.
     kIOModPortStatus_Max,
 } IOModPortStatus_e;
 
+// Conversion applied to a channel for its statistics.
+typedef enum
+{
+    kIOModChannelType_None,
+    // mA, as IOModGetCurrent.
+    kIOModChannelType_Current,
+    // Thermistor, milli-degrees C as IOModGetTemperature.
+    kIOModChannelType_Temperature,
+    // Reserved for future use, keep last.
+    kIOModChannelType_Max,
+} IOModChannelType_e;
+
+// Conversion mode of a slave, see IOModSetChannelPeriod.
+typedef enum
+{
+    // Round robin over and over.
+    kIOModScheduleMode_Continuous,
+    // One round robin every kADC128D818_LowPowerCycleUs.
+    kIOModScheduleMode_LowPower,
+    // Round robin started by the scan once per period, deep shutdown in between.
+    kIOModScheduleMode_OneShot,
+    // No channel to convert, deep shutdown.
+    kIOModScheduleMode_Shutdown,
+    // Reserved for future use, keep last.
+    kIOModScheduleMode_Max,
+} IOModScheduleMode_e;
+
 // ----------------------------------------------------------------------------
 // Data types
 // ----------------------------------------------------------------------------
@@ -49,6 +120,58 @@ typedef struct
     uint8_t minor;
 } IOModVersion_t;
 
+typedef struct
+{
+    // Time of the read, as passed to IOModScanProcess.
+    uint32_t timestampUs;
+    uint16_t rawData;
+} IOModSample_t;
+
+typedef struct
+{
+    // Time of the sample completing the output.
+    uint32_t timestampUs;
+    // Raw ADC code, Q kIOModFilterFractionBits.
+    uint32_t value;
+} IOModFilteredSample_t;
+
+/// Called once all readings of an IOModScanSubmit batch are done, kIOModPortStatus_DriverBusError if one failed.
+typedef void (*IOModScanCallback_t)(IOModPortStatus_e inStatus, void* inContext);
+/// Called by IOModHandleAlert for each slave with limit events, bit n of inChannelMask = channel n out of its limits.
+typedef void (*IOModAlertCallback_t)(uint8_t inSlaveID, uint8_t inChannelMask, void* inContext);
+
+// Channels disabled on each slave (bit n = channel n), all channels are converted by default. Can be stored in the
+// board config, ex: mField(User, ChannelMasks, IOModChannelMasks_t, kIOModChannelMasksDefault).
+typedef struct
+{
+    uint8_t disableMask[kIOModMaxSlaves];
+} IOModChannelMasks_t;
+#define kIOModChannelMasksDefault { { 0 } }
+
+// Current calibration of each channel (see IOModSetChannelCalibration). Can be stored in the board config,
+// ex: mField(Factory, Calibrations, IOModCalibrations_t, kIOModCalibrationsDefault).
+typedef struct
+{
+    ConversionCalibration_t channels[kIOModMaxSlaves][kIOModChannelsPerSlave];
+} IOModCalibrations_t;
+#define kIOModCalibrationsDefault { { { { { 0 } } } } }
+
+typedef struct
+{
+    // IOModScheduleMode_e.
+    uint8_t mode;
+    // Channels converted (bit n = channel n).
+    uint8_t channelMask;
+    // Channels with a period, converted less often than it or not at all.
+    uint8_t missedMask;
+    // Round robin duration.
+    uint32_t cycleUs;
+    // Time between two conversions of a channel, measured for one-shot once two were done. 0 if none.
+    uint32_t periodUs;
+    // Estimated share of the time converting, parts per million.
+    uint32_t dutyCyclePpm;
+} IOModSchedule_t;
+
 typedef struct
 {
     // TODO: Add enum for models.
@@ -59,13 +182,104 @@ typedef struct
 // ----------------------------------------------------------------------------
 // Function prototypes
 // ----------------------------------------------------------------------------
+/// Bus device of a slave, mIOModBusDevice(inSlaveID / kIOModSlavesPerBus, address).
+uint16_t IOModGetADCDevice(uint8_t inSlaveID);
+/// Probe all slaves of all buses (manufacturer ID read). Slaves not found then return kIOModPortStatus_NotDetected
+/// without bus access, IOModADCInit skips them and the scan drops them. Slaves not answered within
+/// kIOModDiscoverTimeoutUs are absent. kIOModPortStatus_NotDetected if no slave is found, kIOModPortStatus_Pending
+/// while probes of a timed out discovery are still queued.
+IOModPortStatus_e IOModDiscover(void);
+/// Slave found by IOModDiscover, true for all valid slaves before discovery.
+bool IOModIsPresent(uint8_t inSlaveID);
 ///
 IOModPortStatus_e IOModADCInit(uint8_t inSlaveID);
 ///
 IOModPortStatus_e IOModGetTemperature(uint8_t inSlaveID, uint8_t inChannelIdx, int32_t* outADCData);
-///
+/// Blocking read of the internal temperature (waits kIOModInternalTemperatureSettleUs), or latest value acquired by the scan engine
+/// unless older than its period plus the acquisition.
+/// kIOModPortStatus_Pending while an acquisition of the scan engine or IOModInternalTemperatureStart is in progress.
 IOModPortStatus_e IOModGetInternalTemperature(uint8_t inSlaveID, int32_t* outADCData);
-///
+/// Non-blocking internal temperature read: switch the ADC to temperature mode. kIOModPortStatus_NotDetected until
+/// IOModADCInit.
+IOModPortStatus_e IOModInternalTemperatureStart(uint8_t inSlaveID, uint32_t inTimestampUs);
+/// Returns kIOModPortStatus_Pending until settled, then reads the temperature and restores the previous mode.
+IOModPortStatus_e IOModInternalTemperaturePoll(uint8_t inSlaveID, uint32_t inTimestampUs, int32_t* outADCData);
+/// Let the scan engine acquire the internal temperature every inPeriodUs (0 to disable). IN7 is not sampled during acquisitions.
+void IOModScanInternalTemperature(uint8_t inSlaveID, uint32_t inPeriodUs);
+/// Current in mA, kIOModPortStatus_OverLoad above the channel limit.
 IOModPortStatus_e IOModGetCurrent(uint8_t inSlaveID, uint8_t inChannelIdx, int32_t* outADCData);
+/// Overload limit of a channel in mA, converted once to a raw ADC threshold. Applied by IOModADCInit if set before.
+IOModPortStatus_e IOModSetCurrentLimit(uint8_t inSlaveID, uint8_t inChannelIdx, int32_t inLimit);
+/// Current conversion of a channel, multiplier, scale and sign as ConversionDecode plus offset (mA) and gain trim.
+/// Fused once (see ConversionFuse), the conversion then costs the same as without calibration. The limit threshold
+/// is converted again. A multiplier of 0 restores the default conversion.
+IOModPortStatus_e IOModSetChannelCalibration(uint8_t inSlaveID, uint8_t inChannelIdx, const ConversionCalibration_t* inCalibration);
+/// IOModSetChannelCalibration for all channels from an IOModCalibrations_t at inAddress in the board config
+/// (ex: kBoardConfigSchema_Factory_Calibrations_Offset), read one entry at a time. Entries left to 0 keep the default
+/// conversion, entries that can not be read keep their calibration (kIOModPortStatus_DriverBusError).
+IOModPortStatus_e IOModLoadCalibrations(uint32_t inAddress);
+/// Protection fast path: IOModGetCurrent status without the conversion (raw code compared with the threshold).
+IOModPortStatus_e IOModCheckCurrent(uint8_t inSlaveID, uint8_t inChannelIdx);
+/// Read all channels of the next initialized slave (round robin) of each bus into the sample rings. Call periodically from a single task.
+/// Once a channel has samples, the getters above read the latest one instead of the bus, until it is older than the
+/// channel period (or the time between conversions) plus one round robin. Channels are not read again
+/// before the ADC has a new conversion (see IOModGetConversionCycleUs).
+IOModPortStatus_e IOModScanProcess(uint32_t inTimestampUs);
+/// IOModScanProcess for one bus, to run a worker per bus so buses are sampled in parallel.
+IOModPortStatus_e IOModScanProcessBus(uint8_t inBusID, uint32_t inTimestampUs);
+/// Queue the readings of all channels of all initialized slaves on the bus engine (see iomodbus.h) and return.
+/// Samples are stored as IOModScanProcess does, use one or the other. kIOModPortStatus_Pending if the previous batch is not done
+/// or no channel has a new conversion yet. One-shot slaves failing their trigger or busy status read are retried by the next
+/// call and reported as kIOModPortStatus_DriverBusError (returned if nothing else is queued, by the callback otherwise).
+IOModPortStatus_e IOModScanSubmit(uint32_t inTimestampUs, IOModScanCallback_t inCallback, void* inContext);
+/// Latest scanned sample of a channel, kIOModPortStatus_NotDetected if none.
+IOModPortStatus_e IOModGetLatestSample(uint8_t inSlaveID, uint8_t inChannelIdx, IOModSample_t* outSample);
+/// Copy up to inCount scanned samples of a channel, newest first. Returns the number of samples copied.
+uint8_t IOModGetSampleHistory(uint8_t inSlaveID, uint8_t inChannelIdx, IOModSample_t* outSamples, uint8_t inCount);
+/// Enable statistics of a channel (updated by IOModScanProcess on each sample), clears them.
+void IOModSetChannelType(uint8_t inSlaveID, uint8_t inChannelIdx, IOModChannelType_e inType);
+/// Statistics of a channel since the last reset, kIOModPortStatus_NotDetected if no sample yet.
+IOModPortStatus_e IOModGetChannelStats(uint8_t inSlaveID, uint8_t inChannelIdx, IOModStats_t* outStats);
+/// Clear the statistics of a channel, done on the next scan of its slave.
+void IOModResetChannelStats(uint8_t inSlaveID, uint8_t inChannelIdx);
+/// Run the scanned samples of a channel through a decimation / low pass filter (see iomodfilter.h), applied on the next scan.
+/// Returns kIOModPortStatus_Pending if the previous configuration is not applied yet.
+IOModPortStatus_e IOModSetChannelFilter(uint8_t inSlaveID, uint8_t inChannelIdx, const IOModFilterConfig_t* inConfig);
+/// Latest filter output of a channel, kIOModPortStatus_NotDetected if none yet.
+IOModPortStatus_e IOModGetFiltered(uint8_t inSlaveID, uint8_t inChannelIdx, IOModFilteredSample_t* outSample);
+/// Convert only the channels in inChannelMask (bit n = channel n), applied now if the slave is initialized or by
+/// IOModADCInit. The ADC round robin then only takes the enabled channels, the scan skips the others and their getters
+/// return kIOModPortStatus_NotDetected. IN7 must be enabled for internal temperature reads.
+IOModPortStatus_e IOModSetChannelMask(uint8_t inSlaveID, uint8_t inChannelMask);
+/// Enabled channels of a slave.
+uint8_t IOModGetChannelMask(uint8_t inSlaveID);
+/// IOModSetChannelMask for all slaves from an IOModChannelMasks_t at inAddress in the board config
+/// (ex: kBoardConfigSchema_User_ChannelMasks_Offset).
+IOModPortStatus_e IOModLoadChannelMasks(uint32_t inAddress);
+/// Estimated time between two conversions of a channel of a slave (converted channels, mode and schedule): each
+/// channel has a new conversion at least once per cycle.
+uint32_t IOModGetConversionCycleUs(uint8_t inSlaveID);
+/// Sample period a channel needs (the shortest of its consumers), 0 if none. A slave with periods only converts the
+/// enabled channels with one, and picks from the shortest: continuous, low power or one-shot then deep shutdown
+/// (see kIOModOneShotPeriodMinUs), triggered by the scan. Others convert all enabled channels continuously. Applied now
+/// if the slave is initialized or by IOModADCInit. Getters of the channels not converted return kIOModPortStatus_NotDetected.
+IOModPortStatus_e IOModSetChannelPeriod(uint8_t inSlaveID, uint8_t inChannelIdx, uint32_t inPeriodUs);
+/// Conversion schedule of a slave: mode, achieved period, estimated duty cycle and channels missing their period.
+IOModPortStatus_e IOModGetSchedule(uint8_t inSlaveID, IOModSchedule_t* outSchedule);
+/// Read a channel only if a new conversion was done since the previous IOModReadIfNew of the channel, from the scanned
+/// samples if there is a newer one. kIOModPortStatus_Pending without bus access otherwise, also on the first read of a
+/// channel whose latest scanned sample is older than its period plus a round robin. One caller per channel.
+IOModPortStatus_e IOModReadIfNew(uint8_t inSlaveID, uint8_t inChannelIdx, uint32_t inTimestampUs, IOModSample_t* outSample);
+/// Program the hardware limits of a channel in raw ADC codes (compared by the ADC on 16 codes resolution), once the
+/// slave is initialized.
+IOModPortStatus_e IOModSetChannelLimits(uint8_t inSlaveID, uint8_t inChannelIdx, uint16_t inLowRawData, uint16_t inHighRawData);
+/// Let limit events of the channels in inChannelMask assert the INT output of an initialized slave, 0 to disable.
+IOModPortStatus_e IOModEnableAlerts(uint8_t inSlaveID, uint8_t inChannelMask);
+/// Set the callback of IOModHandleAlert.
+void IOModSetAlertCallback(IOModAlertCallback_t inCallback, void* inContext);
+/// To call from a task when the INT line of a bus is asserted (INT outputs of a bus can be wired together). Reads the
+/// interrupt status of the slaves of the bus with alerts enabled, which releases INT, and calls the alert callback.
+/// kIOModPortStatus_NotDetected if no slave had events.
+IOModPortStatus_e IOModHandleAlert(uint8_t inBusID);
 
 #endif // IOMOD_H_
@@ -0,0 +1,343 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+// Standard includes.
+#include <stddef.h>
+
+// Lib includes.
+#include "iomodbus.h"
+#include "iomodutils.h"
+#include "i2c.h"
+
+// ----------------------------------------------------------------------------
+// Private types.
+typedef struct
+{
+    IOModBusPort_t port;
+    IOModBusTransaction_t* head;
+    IOModBusTransaction_t* tail;
+    // Transaction being transferred by the port.
+    IOModBusTransaction_t* volatile active;
+} IOModBusEngine_t;
+
+// Private variables.
+static IOModBusEngine_t gBusEngines[kIOModBusMax];
+
+// ----------------------------------------------------------------------------
+static void IOModBusLock(IOModBusEngine_t* inEngine)
+{
+    if (inEngine->port.lockFunction)
+    {
+        inEngine->port.lockFunction(inEngine->port.lock);
+    }
+}
+
+// ----------------------------------------------------------------------------
+static void IOModBusUnlock(IOModBusEngine_t* inEngine)
+{
+    if (inEngine->port.unlockFunction)
+    {
+        inEngine->port.unlockFunction(inEngine->port.lock);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Must be called locked.
+static IOModBusTransaction_t* IOModBusPop(IOModBusEngine_t* inEngine)
+{
+    IOModBusTransaction_t* transaction = inEngine->head;
+
+    if (transaction)
+    {
+        inEngine->head = transaction->next;
+        if (inEngine->head == NULL)
+        {
+            inEngine->tail = NULL;
+        }
+        transaction->next = NULL;
+    }
+
+    return transaction;
+}
+
+// ----------------------------------------------------------------------------
+static void IOModBusFinish(IOModBusTransaction_t* inTransaction, int inStatus)
+{
+    inTransaction->status = inStatus;
+    inTransaction->done = true;
+
+    if (inTransaction->callback)
+    {
+        inTransaction->callback(inTransaction);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Start the next queued transaction on the port, if the bus is free.
+static void IOModBusStartNext(IOModBusEngine_t* inEngine)
+{
+    while (1)
+    {
+        IOModBusLock(inEngine);
+        IOModBusTransaction_t* transaction = NULL;
+        if (inEngine->active == NULL)
+        {
+            transaction = IOModBusPop(inEngine);
+            inEngine->active = transaction;
+        }
+        IOModBusUnlock(inEngine);
+
+        if (transaction == NULL)
+        {
+            return;
+        }
+
+        int status = inEngine->port.start(transaction, inEngine->port.startContext);
+        if (status == 0)
+        {
+            return;
+        }
+
+        // Could not start, fail it and try the next one.
+        IOModBusLock(inEngine);
+        inEngine->active = NULL;
+        IOModBusUnlock(inEngine);
+        IOModBusFinish(transaction, status);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IOModBusInit(uint8_t inBusID, const IOModBusPort_t* inPort)
+{
+    mIOAssertArg(inBusID < kIOModBusMax);
+
+    IOModBusEngine_t* engine = &gBusEngines[inBusID];
+    engine->port = *inPort;
+    engine->head = NULL;
+    engine->tail = NULL;
+    engine->active = NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Blocking transfer with the port functions, or the I2C functions without.
+static int IOModBusTransfer(IOModBusEngine_t* inEngine, IOModBusTransaction_t* inTransaction)
+{
+    uint8_t address = mIOModBusDeviceAddress(inTransaction->device);
+
+    if (inTransaction->operation == kIOModBusOperation_WriteRegister)
+    {
+        if (inEngine->port.writeRegister)
+        {
+            return inEngine->port.writeRegister(address, inTransaction->reg, inTransaction->data, inTransaction->size);
+        }
+        return I2CWriteRegister(address, inTransaction->reg, inTransaction->data, inTransaction->size);
+    }
+
+    if (inEngine->port.readRegister)
+    {
+        return inEngine->port.readRegister(address, inTransaction->reg, inTransaction->data, inTransaction->size);
+    }
+    return I2CReadRegister(address, inTransaction->reg, inTransaction->data, inTransaction->size);
+}
+
+// ----------------------------------------------------------------------------
+// Blocking access, queued behind the transactions of the bus so it never interleaves with them.
+static int IOModBusBlockingTransfer(IOModBusTransaction_t* inTransaction)
+{
+    uint8_t busID = mIOModBusDeviceBus(inTransaction->device);
+
+    if (busID >= kIOModBusMax)
+    {
+        return -1;
+    }
+
+    IOModBusSubmit(inTransaction);
+    while (!inTransaction->done)
+    {
+        // Polled buses are transferred by the task processing them, this one included. No-op on interrupt driven buses.
+        IOModBusProcess(busID);
+    }
+
+    return inTransaction->status;
+}
+
+// ----------------------------------------------------------------------------
+int IOModBusReadRegister(uint16_t inDevice, uint8_t inRegister, uint8_t* outData, uint16_t inSize)
+{
+    IOModBusTransaction_t transaction = { .operation = kIOModBusOperation_ReadRegister, .device = inDevice, .reg = inRegister, .data = outData, .size = inSize };
+
+    return IOModBusBlockingTransfer(&transaction);
+}
+
+// ----------------------------------------------------------------------------
+int IOModBusWriteRegister(uint16_t inDevice, uint8_t inRegister, uint8_t* inData, uint16_t inSize)
+{
+    IOModBusTransaction_t transaction = { .operation = kIOModBusOperation_WriteRegister, .device = inDevice, .reg = inRegister, .data = inData, .size = inSize };
+
+    return IOModBusBlockingTransfer(&transaction);
+}
+
+// ----------------------------------------------------------------------------
+void IOModBusSubmit(IOModBusTransaction_t* inTransaction)
+{
+    IOModBusSubmitBatch(inTransaction, 1);
+}
+
+// ----------------------------------------------------------------------------
+void IOModBusSubmitBatch(IOModBusTransaction_t inTransactions[], uint16_t inCount)
+{
+    for (uint8_t busID = 0; busID < kIOModBusMax; busID ++)
+    {
+        IOModBusEngine_t* engine = &gBusEngines[busID];
+        IOModBusTransaction_t* first = NULL;
+        IOModBusTransaction_t* last = NULL;
+
+        // Link the transactions of this bus before taking the lock.
+        for (uint16_t transactionIdx = 0; transactionIdx < inCount; transactionIdx ++)
+        {
+            IOModBusTransaction_t* transaction = &inTransactions[transactionIdx];
+            if (mIOModBusDeviceBus(transaction->device) != busID)
+            {
+                continue;
+            }
+
+            transaction->next = NULL;
+            transaction->done = false;
+            if (last)
+            {
+                last->next = transaction;
+            }
+            else
+            {
+                first = transaction;
+            }
+            last = transaction;
+        }
+
+        if (first == NULL)
+        {
+            continue;
+        }
+
+        IOModBusLock(engine);
+        if (engine->tail)
+        {
+            engine->tail->next = first;
+        }
+        else
+        {
+            engine->head = first;
+        }
+        engine->tail = last;
+        IOModBusUnlock(engine);
+
+        if (engine->port.start)
+        {
+            IOModBusStartNext(engine);
+        }
+    }
+
+    // Transactions on a bus that does not exist.
+    for (uint16_t transactionIdx = 0; transactionIdx < inCount; transactionIdx ++)
+    {
+        if (mIOModBusDeviceBus(inTransactions[transactionIdx].device) >= kIOModBusMax)
+        {
+            IOModBusFinish(&inTransactions[transactionIdx], -1);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IOModBusComplete(uint8_t inBusID, int inStatus)
+{
+    mIOAssertArg(inBusID < kIOModBusMax);
+    if (inBusID >= kIOModBusMax)
+    {
+        return;
+    }
+
+    IOModBusEngine_t* engine = &gBusEngines[inBusID];
+
+    IOModBusLock(engine);
+    IOModBusTransaction_t* transaction = engine->active;
+    engine->active = NULL;
+    IOModBusUnlock(engine);
+
+    if (transaction == NULL)
+    {
+        return;
+    }
+
+    // Keep the bus busy before running the callback.
+    IOModBusStartNext(engine);
+    IOModBusFinish(transaction, inStatus);
+}
+
+// ----------------------------------------------------------------------------
+uint16_t IOModBusProcess(uint8_t inBusID)
+{
+    mIOAssertArg(inBusID < kIOModBusMax);
+
+    IOModBusEngine_t* engine = &gBusEngines[inBusID];
+    uint16_t count = 0;
+
+    if (engine->port.start)
+    {
+        return 0;
+    }
+
+    while (1)
+    {
+        // Another task is transferring (blocking access or IOModBusProcess).
+        IOModBusLock(engine);
+        IOModBusTransaction_t* transaction = NULL;
+        if (engine->active == NULL)
+        {
+            transaction = IOModBusPop(engine);
+            engine->active = transaction;
+        }
+        IOModBusUnlock(engine);
+
+        if (transaction == NULL)
+        {
+            return count;
+        }
+
+        int status = IOModBusTransfer(engine, transaction);
+
+        IOModBusLock(engine);
+        engine->active = NULL;
+        IOModBusUnlock(engine);
+        IOModBusFinish(transaction, status);
+        count ++;
+    }
+}
+
+// ----------------------------------------------------------------------------
+bool IOModBusIdle(uint8_t inBusID)
+{
+    mIOAssertArg(inBusID < kIOModBusMax);
+
+    IOModBusEngine_t* engine = &gBusEngines[inBusID];
+
+    IOModBusLock(engine);
+    bool idle = (engine->head == NULL) && (engine->active == NULL);
+    IOModBusUnlock(engine);
+
+    return idle;
+}
@@ -0,0 +1,117 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef IOMODBUS_H_
+#define IOMODBUS_H_
+
+// Standard includes.
+#include <stdbool.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+// Number of I2C buses.
+#ifndef kIOModBusMax
+#define kIOModBusMax 1
+#endif
+
+typedef enum
+{
+    kIOModBusOperation_ReadRegister,
+    kIOModBusOperation_WriteRegister,
+} IOModBusOperation_e;
+
+// ----------------------------------------------------------------------------
+// Macros
+// ----------------------------------------------------------------------------
+// Device identifier: bus in the MSB, 7-bit I2C address in the LSB. Bus 0 devices are plain addresses.
+#define mIOModBusDevice(bus, address) ((uint16_t)(((bus) << 8) | (address)))
+#define mIOModBusDeviceBus(device) ((uint8_t)((device) >> 8))
+#define mIOModBusDeviceAddress(device) ((uint8_t)((device) & 0xFF))
+
+// ----------------------------------------------------------------------------
+// Data types
+// ----------------------------------------------------------------------------
+typedef struct IOModBusTransaction_s IOModBusTransaction_t;
+
+/// Called once the transaction is done (from the completion interrupt or IOModBusProcess).
+typedef void (*IOModBusCallback_t)(IOModBusTransaction_t* inTransaction);
+/// Start the transfer and return 0, IOModBusComplete must then be called once done.
+typedef int (*IOModBusStart_t)(IOModBusTransaction_t* inTransaction, void* inContext);
+/// Blocking register access, same as I2CReadRegister / I2CWriteRegister.
+typedef int (*IOModBusReadRegister_t)(uint8_t inAddress, uint8_t inRegister, uint8_t* outData, uint16_t inSize);
+typedef int (*IOModBusWriteRegister_t)(uint8_t inAddress, uint8_t inRegister, uint8_t* inData, uint16_t inSize);
+typedef void (*IOModBusLock_t)(void* inLock);
+typedef void (*IOModBusUnlock_t)(void* inLock);
+
+// Transaction descriptor, owned by the bus engine from submission to callback.
+struct IOModBusTransaction_s
+{
+    // Intrusive queue link.
+    IOModBusTransaction_t* next;
+    // IOModBusOperation_e.
+    uint8_t operation;
+    // mIOModBusDevice(bus, address).
+    uint16_t device;
+    uint8_t reg;
+    uint8_t* data;
+    uint16_t size;
+    // Bus status (0 on success), valid once done.
+    int status;
+    volatile bool done;
+    // Optional.
+    IOModBusCallback_t callback;
+    void* context;
+};
+
+typedef struct
+{
+    // Optional, blocking register access of the bus (I2CReadRegister / I2CWriteRegister if not set).
+    IOModBusReadRegister_t readRegister;
+    IOModBusWriteRegister_t writeRegister;
+    // Optional, interrupt / DMA driven transfers. IOModBusProcess does the transfers with the blocking I2C functions otherwise.
+    IOModBusStart_t start;
+    void* startContext;
+    // Optional, protect the queue against the completion interrupt and other tasks.
+    void* lock;
+    IOModBusLock_t lockFunction;
+    IOModBusUnlock_t unlockFunction;
+} IOModBusPort_t;
+
+// ----------------------------------------------------------------------------
+// Function prototypes
+// ----------------------------------------------------------------------------
+/// Set the port of a bus, its queue must be empty. Buses without a port use the I2C functions.
+void IOModBusInit(uint8_t inBusID, const IOModBusPort_t* inPort);
+/// Blocking register read / write on the bus of the device, queued after the transactions already submitted and
+/// waited for (polled buses are processed meanwhile). Not from a completion callback of an interrupt driven bus.
+int IOModBusReadRegister(uint16_t inDevice, uint8_t inRegister, uint8_t* outData, uint16_t inSize);
+int IOModBusWriteRegister(uint16_t inDevice, uint8_t inRegister, uint8_t* inData, uint16_t inSize);
+/// Queue a transaction on the bus of its device, transfers of a bus run back to back.
+void IOModBusSubmit(IOModBusTransaction_t* inTransaction);
+/// Queue inCount transactions at once, each bus gets its transactions in array order.
+void IOModBusSubmitBatch(IOModBusTransaction_t inTransactions[], uint16_t inCount);
+/// Transfer of the active transaction of a bus is done, to be called by the port (ex: from the I2C interrupt). Starts the next one.
+void IOModBusComplete(uint8_t inBusID, int inStatus);
+/// Without a start function: do the queued transfers of a bus. Returns the number of transactions done.
+uint16_t IOModBusProcess(uint8_t inBusID);
+/// True when no transaction is queued or active on the bus.
+bool IOModBusIdle(uint8_t inBusID);
+
+#endif // IOMODBUS_H_
@@ -0,0 +1,96 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+// Standard includes.
+#include <string.h>
+
+// Lib includes.
+#include "iomodfilter.h"
+
+// ----------------------------------------------------------------------------
+int IOModFilterInit(IOModFilter_t* outFilter, const IOModFilterConfig_t* inConfig)
+{
+    uint8_t cicOrder = inConfig->cicOrder ? inConfig->cicOrder : 1;
+
+    // Phase is 16 bits.
+    if ((cicOrder > kIOModFilterMaxCICOrder) || (inConfig->decimationShift > 15) || ((inConfig->decimationShift * cicOrder) > kIOModFilterMaxGainShift) || (inConfig->iirShift > 16))
+    {
+        return -1;
+    }
+
+    memset(outFilter, 0, sizeof(*outFilter));
+    outFilter->config = *inConfig;
+    outFilter->config.cicOrder = cicOrder;
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+bool IOModFilterProcess(IOModFilter_t* inFilter, uint16_t inRawData, uint32_t* outValue)
+{
+    uint8_t cicOrder = inFilter->config.cicOrder;
+    uint32_t value = inRawData;
+
+    // Integrators at the input rate.
+    for (uint8_t stageIdx = 0; stageIdx < cicOrder; stageIdx ++)
+    {
+        inFilter->integrators[stageIdx] += value;
+        value = inFilter->integrators[stageIdx];
+    }
+
+    inFilter->phase ++;
+    if (inFilter->phase < (1 << inFilter->config.decimationShift))
+    {
+        return false;
+    }
+    inFilter->phase = 0;
+
+    // Combs at the output rate.
+    for (uint8_t stageIdx = 0; stageIdx < cicOrder; stageIdx ++)
+    {
+        uint32_t delayed = inFilter->combs[stageIdx];
+        inFilter->combs[stageIdx] = value;
+        value -= delayed;
+    }
+
+    // Remove the CIC gain, keeping kIOModFilterFractionBits.
+    int8_t shift = kIOModFilterFractionBits - (inFilter->config.decimationShift * cicOrder);
+    value = (shift >= 0) ? (value << shift) : (value >> -shift);
+
+    // A CIC of order N needs N outputs to fill its combs, drop the first ones.
+    if (inFilter->outputCount < cicOrder)
+    {
+        inFilter->outputCount ++;
+        if (inFilter->outputCount < cicOrder)
+        {
+            return false;
+        }
+        // Start the low pass from the first valid output.
+        inFilter->iir = (int32_t)value;
+    }
+
+    if (inFilter->config.iirShift)
+    {
+        inFilter->iir += ((int32_t)value - inFilter->iir) >> inFilter->config.iirShift;
+        value = (uint32_t)inFilter->iir;
+    }
+
+    *outValue = value;
+
+    return true;
+}
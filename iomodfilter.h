@@ -0,0 +1,67 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef IOMODFILTER_H_
+#define IOMODFILTER_H_
+
+// Standard includes.
+#include <stdbool.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+// Fraction bits of the filter output (raw ADC code in Q kIOModFilterFractionBits).
+#define kIOModFilterFractionBits 8
+#define kIOModFilterMaxCICOrder 3
+// CIC gain is 2^(decimationShift * cicOrder), a 12-bit input must not overflow 32-bit integrators.
+#define kIOModFilterMaxGainShift 20
+
+// ----------------------------------------------------------------------------
+// Data types
+// ----------------------------------------------------------------------------
+typedef struct
+{
+    // Decimation ratio is 1 << decimationShift (0: one output per sample).
+    uint8_t decimationShift;
+    // CIC order, 1 is a boxcar average (0 is the same as 1).
+    uint8_t cicOrder;
+    // One pole low pass after decimation, y += (x - y) >> iirShift (0: bypass).
+    uint8_t iirShift;
+} IOModFilterConfig_t;
+
+typedef struct
+{
+    IOModFilterConfig_t config;
+    // Integrators and comb delays, modulo 2^32 arithmetic.
+    uint32_t integrators[kIOModFilterMaxCICOrder];
+    uint32_t combs[kIOModFilterMaxCICOrder];
+    uint16_t phase;
+    uint8_t outputCount;
+    int32_t iir;
+} IOModFilter_t;
+
+// ----------------------------------------------------------------------------
+// Function prototypes
+// ----------------------------------------------------------------------------
+/// Set the configuration and clear the filter state. Returns -1 if the configuration is not supported.
+int IOModFilterInit(IOModFilter_t* outFilter, const IOModFilterConfig_t* inConfig);
+/// Feed a raw ADC sample, returns true when an output (Q kIOModFilterFractionBits) is produced.
+bool IOModFilterProcess(IOModFilter_t* inFilter, uint16_t inRawData, uint32_t* outValue);
+
+#endif // IOMODFILTER_H_
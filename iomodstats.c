@@ -0,0 +1,147 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+// Lib includes.
+#include "iomodstats.h"
+#include "iomodutils.h"
+
+// ----------------------------------------------------------------------------
+static uint32_t IOModStatsSqrt(uint64_t inValue)
+{
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > inValue)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (inValue >= result + bit)
+        {
+            inValue -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
+
+// ----------------------------------------------------------------------------
+void IOModStatsReset(IOModStatsAccumulator_t* inAccumulator)
+{
+    inAccumulator->sequence ++;
+    mIOModMemoryBarrier();
+    inAccumulator->count = 0;
+    inAccumulator->mean = 0;
+    inAccumulator->m2 = 0;
+    inAccumulator->ema = 0;
+    inAccumulator->min = INT32_MAX;
+    inAccumulator->max = INT32_MIN;
+    mIOModMemoryBarrier();
+    inAccumulator->sequence ++;
+}
+
+// ----------------------------------------------------------------------------
+void IOModStatsUpdate(IOModStatsAccumulator_t* inAccumulator, int32_t inValue)
+{
+    int64_t value = (int64_t)inValue << kIOModStatsFractionBits;
+
+    inAccumulator->sequence ++;
+    mIOModMemoryBarrier();
+
+    inAccumulator->count ++;
+    if (inAccumulator->count == 1)
+    {
+        inAccumulator->mean = value;
+        inAccumulator->m2 = 0;
+        inAccumulator->ema = (int32_t)value;
+        inAccumulator->min = inValue;
+        inAccumulator->max = inValue;
+    }
+    else
+    {
+        // Welford, both deltas have the same sign so the product is positive.
+        int64_t delta = value - inAccumulator->mean;
+        inAccumulator->mean += delta / (int64_t)inAccumulator->count;
+        int64_t delta2 = value - inAccumulator->mean;
+        inAccumulator->m2 += (uint64_t)(delta * delta2) >> (2 * kIOModStatsFractionBits);
+
+        inAccumulator->ema += ((int32_t)value - inAccumulator->ema) >> kIOModStatsEMAShift;
+
+        if (inValue < inAccumulator->min)
+        {
+            inAccumulator->min = inValue;
+        }
+        if (inValue > inAccumulator->max)
+        {
+            inAccumulator->max = inValue;
+        }
+    }
+
+    mIOModMemoryBarrier();
+    inAccumulator->sequence ++;
+}
+
+// ----------------------------------------------------------------------------
+void IOModStatsSnapshot(IOModStatsAccumulator_t* inAccumulator, IOModStats_t* outStats)
+{
+    uint32_t sequence;
+    uint32_t count;
+    int64_t mean;
+    uint64_t m2;
+    int32_t ema;
+
+    // Retry while the writer is (or was) updating.
+    do
+    {
+        sequence = inAccumulator->sequence;
+        mIOModMemoryBarrier();
+        count = inAccumulator->count;
+        mean = inAccumulator->mean;
+        m2 = inAccumulator->m2;
+        ema = inAccumulator->ema;
+        outStats->min = inAccumulator->min;
+        outStats->max = inAccumulator->max;
+        mIOModMemoryBarrier();
+    } while ((sequence & 1) || (sequence != inAccumulator->sequence));
+
+    outStats->count = count;
+    if (count == 0)
+    {
+        outStats->mean = 0;
+        outStats->variance = 0;
+        outStats->ema = 0;
+        outStats->rms = 0;
+        return;
+    }
+
+    // Round to nearest.
+    outStats->mean = (int32_t)((mean + (1 << (kIOModStatsFractionBits - 1))) >> kIOModStatsFractionBits);
+    outStats->ema = (ema + (1 << (kIOModStatsFractionBits - 1))) >> kIOModStatsFractionBits;
+    outStats->variance = (count > 1) ? m2 / (count - 1) : 0;
+    // RMS^2 = mean of squares = population variance + mean^2.
+    uint64_t meanSquare = (uint64_t)(mean * mean) >> (2 * kIOModStatsFractionBits);
+    outStats->rms = (int32_t)IOModStatsSqrt(m2 / count + meanSquare);
+}
@@ -0,0 +1,76 @@
+/* Copyright (C) 2016, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef IOMODSTATS_H_
+#define IOMODSTATS_H_
+
+// Standard includes.
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+// EMA weight of a new sample is 1 / 2^kIOModStatsEMAShift.
+#ifndef kIOModStatsEMAShift
+#define kIOModStatsEMAShift 3
+#endif
+
+// Fraction bits of the mean and EMA accumulators.
+#define kIOModStatsFractionBits 8
+
+// ----------------------------------------------------------------------------
+// Data types
+// ----------------------------------------------------------------------------
+// Incremental statistics, single writer (IOModStatsUpdate) / multiple readers (IOModStatsSnapshot).
+typedef struct
+{
+    // Odd while an update is in progress.
+    volatile uint32_t sequence;
+    uint32_t count;
+    // Welford mean (Q kIOModStatsFractionBits) and sum of squared deviations.
+    int64_t mean;
+    uint64_t m2;
+    // Q kIOModStatsFractionBits.
+    int32_t ema;
+    int32_t min;
+    int32_t max;
+} IOModStatsAccumulator_t;
+
+typedef struct
+{
+    uint32_t count;
+    int32_t mean;
+    // Sample variance (unit^2).
+    uint64_t variance;
+    int32_t ema;
+    int32_t rms;
+    int32_t min;
+    int32_t max;
+} IOModStats_t;
+
+// ----------------------------------------------------------------------------
+// Function prototypes
+// ----------------------------------------------------------------------------
+/// Clear the accumulator, from the writer context.
+void IOModStatsReset(IOModStatsAccumulator_t* inAccumulator);
+/// Add a sample (O(1), no division besides one 64-bit divide by the count).
+void IOModStatsUpdate(IOModStatsAccumulator_t* inAccumulator, int32_t inValue);
+/// Consistent copy of the statistics, can be called from any context while the writer updates.
+void IOModStatsSnapshot(IOModStatsAccumulator_t* inAccumulator, IOModStats_t* outStats);
+
+#endif // IOMODSTATS_H_
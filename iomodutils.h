@@ -51,6 +51,7 @@ typedef enum
 #define mIOValidateBus(returnStatus) if (returnStatus != 0) { return kIOMod_BusError | returnStatus; }
 #define mIOValidateDriver(returnStatus) if (returnStatus != 0) { return kIOMod_DriverError | returnStatus; }
 #define mIOAssertArg(expr) ((expr) ? (void)0: AssertFailure((uint8_t *)__FILE__, __LINE__, __FUNCTION__))
+#define mIOModMemoryBarrier() __sync_synchronize()
 #define mHTONS(x) (((x) & 0x00ff) << 8 | ((x) & 0xff00) >> 8)
 
 // ----------------------------------------------------------------------------
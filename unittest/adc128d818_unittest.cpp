@@ -0,0 +1,109 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "iomodbus.h"
+#include "adc128d818.h"
+#include "adc128d818sim.h"
+#include "utils.h"
+};
+
+// Hooks of the library, on the simulated time.
+extern "C" {
+void DelayUs(uint32_t inUs)
+{
+    ADC128D818SimAdvance(inUs);
+}
+
+void AssertFailure(const uint8_t* inFile, uint32_t inLine, const char* inFunction)
+{
+    ADD_FAILURE() << "Assert in " << inFunction << " (" << inFile << ":" << inLine << ")";
+}
+};
+
+static const uint16_t kDevice = mIOModBusDevice(0, kADC128D818_SlaveAddress1);
+
+// The driver keeps its register cache between tests, each test starts from an init of a new simulated device.
+class GivenInitializedADC : public ::testing::Test{
+    protected:
+        GivenInitializedADC(){
+            ADC128D818SimReset();
+            ADC128D818SimAddDevice(kDevice);
+            EXPECT_EQ(ADC128D818Init(kDevice), 0);
+        }
+
+        ADC128D818SimBusStats_t Stats(){
+            ADC128D818SimBusStats_t stats;
+            ADC128D818SimGetBusStats(0, &stats);
+            return stats;
+        }
+
+        uint8_t ChannelDisable(){
+            uint8_t channelDisable = 0;
+            EXPECT_EQ(ADC128D818SimReadRegister(kDevice, kADC128D818_RegisterChannelDisable, &channelDisable, 1), 0);
+            return channelDisable;
+        }
+};
+
+TEST_F(GivenInitializedADC, WhenRegisterUnchangedThenWriteShouldBeSkipped){
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    uint32_t writes = Stats().writes;
+
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    EXPECT_EQ(Stats().writes, writes);
+}
+
+TEST_F(GivenInitializedADC, WhenCacheInvalidatedThenNextWriteShouldReachTheDevice){
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    uint32_t writes = Stats().writes;
+
+    ADC128D818InvalidateCache(kDevice);
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    EXPECT_GT(Stats().writes, writes);
+    EXPECT_EQ(ChannelDisable(), 0xF0);
+
+    // Valid again.
+    writes = Stats().writes;
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    EXPECT_EQ(Stats().writes, writes);
+}
+
+TEST_F(GivenInitializedADC, WhenSyncedAfterPowerCycleThenCacheShouldMatchTheDevice){
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    ADC128D818SimPowerCycle(kDevice);
+    ADC128D818SimAdvance(kADC128D818_PowerUpUs);
+    EXPECT_EQ(ChannelDisable(), 0x00);
+
+    uint32_t reads = Stats().reads;
+    EXPECT_EQ(ADC128D818SyncCache(kDevice), 0);
+    EXPECT_EQ(Stats().reads - reads, (uint32_t)kADC128D818_Cache_Max);
+
+    // The cache holds the reset value, the mask is written again.
+    uint32_t writes = Stats().writes;
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0x0F), 0);
+    EXPECT_GT(Stats().writes, writes);
+    EXPECT_EQ(ChannelDisable(), 0xF0);
+
+    // Back to the reset value.
+    writes = Stats().writes;
+    EXPECT_EQ(ADC128D818SetChannelMask(kDevice, 0xFF), 0);
+    EXPECT_GT(Stats().writes, writes);
+    EXPECT_EQ(ChannelDisable(), 0x00);
+}
@@ -0,0 +1,635 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "shadow_memory_medium_mock.hpp"
+
+extern "C" {
+#include "boardconfig.h"
+#include "boardconfigschema.h"
+#include "crc16.h"
+};
+
+using ::testing::AnyNumber;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::_;
+
+// Second instance, stored after the default one.
+#define kSecondInstanceAddress (kBoardConfigStartAddress + kBoardConfigTotalSize)
+
+// Medium holding the config at kBoardConfigStartAddress and room for a second instance, erased to 0xFF.
+class GivenBoardConfigMedium : public ::testing::Test
+{
+    protected:
+        GivenBoardConfigMedium() : medium(kSecondInstanceAddress + kBoardConfigTotalSize, 0xFF)
+        {
+            ShadowMemoryMediumMock_SetGlobalPointer(&medium_mock);
+            memset(&config, 0, sizeof(config));
+            config.write_to_medium = ShadowMemoryMediumMock_WriteToMedium;
+            config.read_from_medium = ShadowMemoryMediumMock_ReadFromMedium;
+            config.get_defaults = BoardConfig_SchemaGetDefaults;
+            config.lock = ShadowMemoryMediumMock_Lock;
+            config.unlock = ShadowMemoryMediumMock_Unlock;
+        }
+
+        void SetUp() override
+        {
+            ON_CALL(medium_mock, WriteToMedium(_, _, _)).WillByDefault(Invoke(this, &GivenBoardConfigMedium::WriteToMedium));
+            ON_CALL(medium_mock, ReadFromMedium(_, _, _)).WillByDefault(Invoke(this, &GivenBoardConfigMedium::ReadFromMedium));
+            NewInstance();
+        }
+
+        // Instance state as after a reboot, the medium is kept.
+        void NewInstance()
+        {
+            memset(&instance, 0, sizeof(instance));
+            instance.memory = memory;
+            instance.double_buffer = double_buffer;
+            instance.offset_on_medium = kBoardConfigStartAddress;
+        }
+
+        uint32_t WriteToMedium(uint32_t address, const uint8_t* data, uint32_t size)
+        {
+            memcpy(&medium[address], data, size);
+            return size;
+        }
+
+        uint32_t ReadFromMedium(uint32_t address, uint8_t* destination, uint32_t size)
+        {
+            memcpy(destination, &medium[address], size);
+            return size;
+        }
+
+        uint8_t* Image()
+        {
+            return &medium[kBoardConfigStartAddress];
+        }
+
+        // Store the defaults in the given layout, without header. SealImage makes it valid.
+        void StoreImage(uint8_t layout)
+        {
+            BoardConfig_SchemaGetDefaults(Image(), kBoardConfigTotalSize);
+            Image()[kBoardConfig_Factory_FlashLayout] = layout;
+        }
+
+        void SealImage()
+        {
+            UpdateCRC(kBoardConfig_FactoryAddressOffset, kBoardConfig_FactorySize, kBoardConfig_Factory_CRC);
+            UpdateCRC(kBoardConfig_UserAddressOffset, kBoardConfig_UserSize, kBoardConfig_User_CRC);
+        }
+
+        void UpdateCRC(uint32_t offset, uint32_t size, uint32_t crcOffset)
+        {
+            uint16_t crc = mHTONS(CRC16ComputeCRC(0, Image() + offset, size));
+            memcpy(Image() + crcOffset, &crc, sizeof(crc));
+        }
+
+        std::vector<uint8_t> medium;
+        uint8_t memory[kBoardConfigTotalSize];
+        uint8_t double_buffer[kBoardConfigTotalSize];
+        board_config_t instance;
+        board_config_config_t config;
+        NiceMock<ShadowMemoryMediumMock> medium_mock;
+};
+
+TEST(GivenBoardConfigSchema, WhenLaidOutThenSectionsShouldStartAtTheirConfiguredOffset)
+{
+    EXPECT_EQ(kBoardConfigSchema_Factory_Offset, kBoardConfig_FactoryAddressOffset);
+    EXPECT_EQ(kBoardConfigSchema_User_Offset, kBoardConfig_UserAddressOffset);
+    EXPECT_EQ(kBoardConfigSchema_Factory_SerialNumber_Offset, kBoardConfig_FactoryAddressOffset);
+    EXPECT_EQ(kBoardConfigSchema_Factory_HardwareRevision_Offset, kBoardConfig_FactoryAddressOffset + 4);
+    EXPECT_EQ(kBoardConfigSchema_User_DisplayBrightness_Offset, kBoardConfig_UserAddressOffset);
+    EXPECT_EQ(kBoardConfigSchema_User_CurrentLimit_Offset, kBoardConfig_UserAddressOffset + 1);
+    EXPECT_EQ(kBoardConfigSchema_User_CurrentLimit_Size, sizeof(int32_t));
+    EXPECT_EQ(kBoardConfigSchema_User_CurrentLimit_Section, kBoardConfigSchemaSection_User);
+    EXPECT_EQ(kBoardConfigSchema_TotalSize, kBoardConfigTotalSize);
+}
+
+TEST(GivenBoardConfigSchema, WhenDefaultsRequestedThenMagicLayoutAndFieldsShouldBeWritten)
+{
+    uint8_t image[kBoardConfigTotalSize];
+    memset(image, 0xFF, sizeof(image));
+    BoardConfig_SchemaGetDefaults(image, sizeof(image));
+
+    uint16_t magic = mHTONS(kBoardConfig_MagicNumber);
+    EXPECT_EQ(memcmp(image + kBoardConfig_Factory_Magic, &magic, 2), 0);
+    EXPECT_EQ(image[kBoardConfig_Factory_FlashLayout], kVersionConfigLayout);
+
+    uint32_t serialNumber;
+    int32_t currentLimit;
+    memcpy(&serialNumber, image + kBoardConfigSchema_Factory_SerialNumber_Offset, sizeof(serialNumber));
+    memcpy(&currentLimit, image + kBoardConfigSchema_User_CurrentLimit_Offset, sizeof(currentLimit));
+    EXPECT_EQ(serialNumber, 0x12345678u);
+    EXPECT_EQ(image[kBoardConfigSchema_Factory_HardwareRevision_Offset], 3);
+    EXPECT_EQ(image[kBoardConfigSchema_User_DisplayBrightness_Offset], 80);
+    EXPECT_EQ(currentLimit, 300);
+}
+
+TEST(GivenBoardConfigSchema, WhenDestinationTooSmallThenDefaultsShouldNotBeWritten)
+{
+    uint8_t image[kBoardConfigTotalSize];
+    memset(image, 0xFF, sizeof(image));
+    BoardConfig_SchemaGetDefaults(image, sizeof(image) - 1);
+    EXPECT_EQ(image[kBoardConfig_Factory_FlashLayout], 0xFF);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenErasedThenInitShouldStoreDefaultsThatSurviveVerifyAndReboot)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    std::vector<uint8_t> stored(Image(), Image() + kBoardConfigTotalSize);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+
+    // Second boot finds a valid image and leaves the medium untouched.
+    NewInstance();
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(0);
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    EXPECT_EQ(std::vector<uint8_t>(Image(), Image() + kBoardConfigTotalSize), stored);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenFieldSetThenGetterShouldReturnItAndOtherFieldsKeepTheirDefaults)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+
+    int32_t currentLimit = -42;
+    uint8_t displayBrightness = 0;
+    uint32_t serialNumber = 0;
+    EXPECT_EQ(BoardConfigInstance_Set_User_CurrentLimit(&instance, &currentLimit), 0);
+    currentLimit = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_DisplayBrightness(&instance, &displayBrightness), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(currentLimit, -42);
+    EXPECT_EQ(displayBrightness, 80);
+    EXPECT_EQ(serialNumber, 0x12345678u);
+
+    // Stored after the commit.
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), 0);
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    currentLimit = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, -42);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenNotInitializedThenAccessorsShouldFail)
+{
+    int32_t currentLimit = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), -1);
+    EXPECT_EQ(BoardConfigInstance_Set_User_CurrentLimit(&instance, &currentLimit), -1);
+}
+
+TEST(GivenBoardConfigInstance, WhenStorageOrConfigMissingThenInitShouldFail)
+{
+    uint8_t memory[kBoardConfigTotalSize];
+    board_config_t instance;
+    board_config_config_t config;
+    memset(&instance, 0, sizeof(instance));
+    memset(&config, 0, sizeof(config));
+    config.get_defaults = BoardConfig_SchemaGetDefaults;
+
+    EXPECT_EQ(BoardConfigInstance_Init(NULL, &config), -1);
+    EXPECT_EQ(BoardConfigInstance_Init(&instance, &config), -1);
+    instance.memory = memory;
+    EXPECT_EQ(BoardConfigInstance_Init(&instance, &config), -1);
+    instance.double_buffer = memory;
+    EXPECT_EQ(BoardConfigInstance_Init(&instance, NULL), -1);
+    config.get_defaults = NULL;
+    EXPECT_EQ(BoardConfigInstance_Init(&instance, &config), -1);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenNotInitializedThenInstanceApiShouldFail)
+{
+    uint8_t data[4] = {0};
+    EXPECT_EQ(BoardConfigInstance_Read(&instance, 0, data, sizeof(data)), -1);
+    EXPECT_EQ(BoardConfigInstance_Write(&instance, 0, data, sizeof(data)), -1);
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_Begin(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_End(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_AcquireShadow(&instance, 0, sizeof(data)), nullptr);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenTwoInstancesThenEachShouldKeepItsOwnValues)
+{
+    uint8_t secondMemory[kBoardConfigTotalSize];
+    uint8_t secondDoubleBuffer[kBoardConfigTotalSize];
+    board_config_t second;
+    memset(&second, 0, sizeof(second));
+    second.memory = secondMemory;
+    second.double_buffer = secondDoubleBuffer;
+    second.offset_on_medium = kSecondInstanceAddress;
+
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    ASSERT_EQ(BoardConfigInstance_Init(&second, &config), 0);
+    int32_t currentLimit = 100;
+    EXPECT_EQ(BoardConfigInstance_Set_User_CurrentLimit(&instance, &currentLimit), 0);
+    currentLimit = 200;
+    EXPECT_EQ(BoardConfigInstance_Set_User_CurrentLimit(&second, &currentLimit), 0);
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_Commit(&second), 0);
+
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, 100);
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&second, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, 200);
+    int32_t stored;
+    memcpy(&stored, &medium[kSecondInstanceAddress + kBoardConfigSchema_User_CurrentLimit_Offset], sizeof(stored));
+    EXPECT_EQ(stored, 200);
+    memcpy(&stored, &medium[kBoardConfigStartAddress + kBoardConfigSchema_User_CurrentLimit_Offset], sizeof(stored));
+    EXPECT_EQ(stored, 100);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenDefaultInstanceUsedThenItShouldBeStoredAtTheStartAddress)
+{
+    EXPECT_EQ(BoardConfig_DefaultInstance()->offset_on_medium, (uint32_t)kBoardConfigStartAddress);
+    ASSERT_EQ(BoardConfig_Init(&config), 0);
+
+    uint8_t displayBrightness = 25;
+    EXPECT_EQ(BoardConfig_Set_User_DisplayBrightness(&displayBrightness), 0);
+    EXPECT_EQ(BoardConfig_Commit(), 0);
+    EXPECT_EQ(BoardConfig_Verify(), 0);
+    displayBrightness = 0;
+    EXPECT_EQ(BoardConfig_Read(kBoardConfigSchema_User_DisplayBrightness_Offset, &displayBrightness, 1), 0);
+    EXPECT_EQ(displayBrightness, 25);
+    EXPECT_EQ(Image()[kBoardConfigSchema_User_DisplayBrightness_Offset], 25);
+}
+
+#ifdef kBoardConfig_HeaderAddressOffset
+TEST_F(GivenBoardConfigMedium, WhenHeaderValidThenInitShouldOnlyReadTheHeader)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+
+    NewInstance();
+    EXPECT_CALL(medium_mock, ReadFromMedium(kBoardConfigStartAddress + kBoardConfig_HeaderAddressOffset, _, kBoardConfig_HeaderSize)).Times(1);
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(0);
+    EXPECT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenFieldReadAfterFastBootThenOnlyItsChunksShouldBeLoadedOnce)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+
+    // 3 bytes chunks (80 / 32): CurrentLimit (33 to 36) spans chunks 11 and 12.
+    EXPECT_CALL(medium_mock, ReadFromMedium(kBoardConfigStartAddress + 33, _, 6)).Times(1);
+    int32_t currentLimit = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, 300);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenFieldWrittenAfterFastBootThenTheRestOfTheImageShouldBeLoadedBeforeCommit)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+
+    uint8_t displayBrightness = 10;
+    EXPECT_EQ(BoardConfigInstance_Write(&instance, kBoardConfigSchema_User_DisplayBrightness_Offset, &displayBrightness, 1), 0);
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), 0);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    uint32_t serialNumber = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_DisplayBrightness(&instance, &displayBrightness), 0);
+    EXPECT_EQ(serialNumber, 0x12345678u);
+    EXPECT_EQ(displayBrightness, 10);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenBodyCorruptedBehindAValidHeaderThenVerifyShouldRestoreTheDefaults)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    Image()[kBoardConfigSchema_User_DisplayBrightness_Offset] = 10;
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), -1);
+    EXPECT_EQ(Image()[kBoardConfigSchema_User_DisplayBrightness_Offset], 80);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenBodyLoadFailsThenVerifyShouldStoreTheDefaultsOverTheMedium)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    uint32_t serialNumber = 0xCAFE;
+    EXPECT_EQ(BoardConfigInstance_Set_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), 0);
+
+    // First body read fails, the medium reads back fine afterwards.
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_CALL(medium_mock, ReadFromMedium(_, _, _)).WillOnce(Return(0)).WillRepeatedly(Invoke([this](uint32_t address, uint8_t* destination, uint32_t size)
+    {
+        return ReadFromMedium(address, destination, size);
+    }));
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(serialNumber, 0x12345678u);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(serialNumber, 0x12345678u);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenHeaderMissingOnAValidImageThenInitShouldAddIt)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    std::vector<uint8_t> header(Image() + kBoardConfig_HeaderAddressOffset, Image() + kBoardConfig_HeaderAddressOffset + kBoardConfig_HeaderSize);
+    memset(Image() + kBoardConfig_HeaderAddressOffset, 0xFF, kBoardConfig_HeaderSize);
+
+    // Full load and validation, only the header is written.
+    NewInstance();
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(0);
+    EXPECT_CALL(medium_mock, WriteToMedium(kBoardConfigStartAddress + kBoardConfig_HeaderAddressOffset, _, kBoardConfig_HeaderSize)).Times(1);
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(std::vector<uint8_t>(Image() + kBoardConfig_HeaderAddressOffset, Image() + kBoardConfig_HeaderAddressOffset + kBoardConfig_HeaderSize), header);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenHeaderDigestBadThenInitShouldFallBackToTheFullImage)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    Image()[kBoardConfig_HeaderAddressOffset + kBoardConfig_HeaderSize - 1] ^= 0x01;
+
+    NewInstance();
+    EXPECT_CALL(medium_mock, ReadFromMedium(_, _, _)).Times(AnyNumber());
+    EXPECT_CALL(medium_mock, ReadFromMedium(kBoardConfigStartAddress, _, kBoardConfigTotalSize)).Times(1);
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+}
+#endif
+
+// Layout 1 had CurrentLimit 4 bytes further and no DisplayBrightness, layout 0 had it 4 bytes further again.
+static const board_config_move_t kMovesFrom0[] = {
+    {kBoardConfigSchema_User_CurrentLimit_Offset + 8, kBoardConfigSchema_User_CurrentLimit_Offset + 4, sizeof(int32_t)},
+};
+static const board_config_move_t kMovesFrom1[] = {
+    {kBoardConfigSchema_User_CurrentLimit_Offset + 4, kBoardConfigSchema_User_CurrentLimit_Offset, sizeof(int32_t)},
+    {kBoardConfigMigration_FromDefaults, kBoardConfigSchema_User_DisplayBrightness_Offset, sizeof(uint8_t)},
+};
+static const board_config_migration_t kMigrations[] = {
+    {1, 2, kMovesFrom1, sizeof(kMovesFrom1) / sizeof(kMovesFrom1[0])},
+    {0, 1, kMovesFrom0, sizeof(kMovesFrom0) / sizeof(kMovesFrom0[0])},
+};
+
+TEST_F(GivenBoardConfigMedium, WhenLayoutOlderThenInitShouldMigrateTheFieldsAndKeepTheOthers)
+{
+    StoreImage(1);
+    int32_t currentLimit = 1234;
+    uint32_t serialNumber = 0xCAFE;
+    memcpy(Image() + kBoardConfigSchema_User_CurrentLimit_Offset + 4, &currentLimit, sizeof(currentLimit));
+    memcpy(Image() + kBoardConfigSchema_Factory_SerialNumber_Offset, &serialNumber, sizeof(serialNumber));
+    Image()[kBoardConfigSchema_User_DisplayBrightness_Offset] = 7;
+    SealImage();
+    config.migrations = kMigrations;
+    config.migration_count = sizeof(kMigrations) / sizeof(kMigrations[0]);
+
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(Image()[kBoardConfig_Factory_FlashLayout], kVersionConfigLayout);
+    currentLimit = 0;
+    serialNumber = 0;
+    uint8_t displayBrightness = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_DisplayBrightness(&instance, &displayBrightness), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(currentLimit, 1234);
+    EXPECT_EQ(displayBrightness, 80);
+    EXPECT_EQ(serialNumber, 0xCAFEu);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenMigratedThenOnlyTheModifiedChunksShouldBeWritten)
+{
+    StoreImage(1);
+    SealImage();
+    config.migrations = kMigrations;
+    config.migration_count = sizeof(kMigrations) / sizeof(kMigrations[0]);
+
+    // Layout, user CRC and the moved fields (and the header) by chunks, the factory section is not rewritten.
+    uint32_t writtenSize = 0;
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(AnyNumber()).WillRepeatedly(Invoke([this, &writtenSize](uint32_t address, const uint8_t* data, uint32_t size)
+    {
+        uint32_t offset = address - kBoardConfigStartAddress;
+        EXPECT_FALSE((offset <= kBoardConfig_FactoryAddressOffset) && ((offset + size) >= (kBoardConfig_FactoryAddressOffset + kBoardConfigSchema_Factory_Size))) << "Write at " << offset << " size " << size;
+        writtenSize += size;
+        return WriteToMedium(address, data, size);
+    }));
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(Image()[kBoardConfig_Factory_FlashLayout], kVersionConfigLayout);
+    EXPECT_LT(writtenSize, (uint32_t)kBoardConfigTotalSize / 2);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenSeveralLayoutsBehindThenInitShouldChainTheMigrations)
+{
+    StoreImage(0);
+    int32_t currentLimit = -77;
+    memcpy(Image() + kBoardConfigSchema_User_CurrentLimit_Offset + 8, &currentLimit, sizeof(currentLimit));
+    SealImage();
+    config.migrations = kMigrations;
+    config.migration_count = sizeof(kMigrations) / sizeof(kMigrations[0]);
+
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    currentLimit = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, -77);
+    EXPECT_EQ(Image()[kBoardConfig_Factory_FlashLayout], kVersionConfigLayout);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenNoMigrationForTheLayoutThenInitShouldForceTheDefaults)
+{
+    StoreImage(1);
+    uint32_t serialNumber = 0xCAFE;
+    memcpy(Image() + kBoardConfigSchema_Factory_SerialNumber_Offset, &serialNumber, sizeof(serialNumber));
+    SealImage();
+    config.migrations = kMigrations + 1;
+    config.migration_count = 1;
+
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(serialNumber, 0x12345678u);
+    EXPECT_EQ(Image()[kBoardConfig_Factory_FlashLayout], kVersionConfigLayout);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenMigrationsLoopThenInitShouldForceTheDefaults)
+{
+    static const board_config_migration_t kLoop[] = {
+        {1, 3, NULL, 0},
+        {3, 1, NULL, 0},
+    };
+    StoreImage(1);
+    SealImage();
+    config.migrations = kLoop;
+    config.migration_count = sizeof(kLoop) / sizeof(kLoop[0]);
+
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(Image()[kBoardConfig_Factory_FlashLayout], kVersionConfigLayout);
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenWritesStagedThenReadersShouldSeeThePreviousValuesUntilEnd)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    ASSERT_EQ(BoardConfigInstance_Begin(&instance), 0);
+
+    int32_t currentLimit = 500;
+    uint8_t displayBrightness = 20;
+    EXPECT_EQ(BoardConfigInstance_Set_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(BoardConfigInstance_Write(&instance, kBoardConfigSchema_User_DisplayBrightness_Offset, &displayBrightness, 1), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(BoardConfigInstance_Read(&instance, kBoardConfigSchema_User_DisplayBrightness_Offset, &displayBrightness, 1), 0);
+    EXPECT_EQ(currentLimit, 300);
+    EXPECT_EQ(displayBrightness, 80);
+    EXPECT_EQ(Image()[kBoardConfigSchema_User_DisplayBrightness_Offset], 80);
+
+    EXPECT_EQ(BoardConfigInstance_End(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, 500);
+    EXPECT_EQ(Image()[kBoardConfigSchema_User_DisplayBrightness_Offset], 20);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(currentLimit, 500);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenShadowWrittenBeforeBeginThenEndShouldAlsoStoreIt)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    ASSERT_EQ(BoardConfigInstance_Commit(&instance), 0);
+
+    // Not committed, covered by the CRC End computes.
+    int32_t currentLimit = -7;
+    EXPECT_EQ(BoardConfigInstance_Set_User_CurrentLimit(&instance, &currentLimit), 0);
+
+    ASSERT_EQ(BoardConfigInstance_Begin(&instance), 0);
+    uint32_t serialNumber = 42;
+    EXPECT_EQ(BoardConfigInstance_Set_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(BoardConfigInstance_End(&instance), 0);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    serialNumber = 0;
+    currentLimit = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(BoardConfigInstance_Get_User_CurrentLimit(&instance, &currentLimit), 0);
+    EXPECT_EQ(serialNumber, 42u);
+    EXPECT_EQ(currentLimit, -7);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenTransactionOpenThenBeginCommitAndVerifyShouldBeRefused)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_End(&instance), -1);
+    ASSERT_EQ(BoardConfigInstance_Begin(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_Begin(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), -1);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), -1);
+
+    // Nothing staged, nothing written.
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(0);
+    EXPECT_EQ(BoardConfigInstance_End(&instance), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenCommitOrVerifyRunningThenBeginShouldBeRefused)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+
+    // Begin from another task while the medium is written.
+    uint32_t begins = 0;
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(AnyNumber()).WillRepeatedly(Invoke([this, &begins](uint32_t address, const uint8_t* data, uint32_t size)
+    {
+        EXPECT_EQ(BoardConfigInstance_Begin(&instance), -1);
+        begins++;
+        return WriteToMedium(address, data, size);
+    }));
+    EXPECT_EQ(BoardConfigInstance_Commit(&instance), 0);
+    EXPECT_GT(begins, 0u);
+
+    // Invalid image, the defaults are written back.
+    begins = 0;
+    memory[kBoardConfigSchema_Factory_SerialNumber_Offset] ^= 0xFF;
+    Image()[kBoardConfigSchema_Factory_SerialNumber_Offset] ^= 0xFF;
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), -1);
+    EXPECT_GT(begins, 0u);
+
+    EXPECT_EQ(BoardConfigInstance_Begin(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_End(&instance), 0);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenTransactionEndsThenEachDirtyRunShouldBeWrittenSeparately)
+{
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    ASSERT_EQ(BoardConfigInstance_Begin(&instance), 0);
+    uint32_t serialNumber = 0xCAFE;
+    uint8_t displayBrightness = 20;
+    EXPECT_EQ(BoardConfigInstance_Set_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(BoardConfigInstance_Set_User_DisplayBrightness(&instance, &displayBrightness), 0);
+
+    // Layout of the runs depends on the chunk size, none spans from the serial number to the display brightness.
+    uint32_t writtenSize = 0;
+    EXPECT_CALL(medium_mock, WriteToMedium(_, _, _)).Times(AnyNumber()).WillRepeatedly(Invoke([this, &writtenSize](uint32_t address, const uint8_t* data, uint32_t size)
+    {
+        uint32_t offset = address - kBoardConfigStartAddress;
+        EXPECT_FALSE((offset <= kBoardConfigSchema_Factory_SerialNumber_Offset) && ((offset + size) > kBoardConfigSchema_User_DisplayBrightness_Offset)) << "Write at " << offset << " size " << size;
+        writtenSize += size;
+        return WriteToMedium(address, data, size);
+    }));
+    EXPECT_EQ(BoardConfigInstance_End(&instance), 0);
+    EXPECT_LT(writtenSize, (uint32_t)kBoardConfigTotalSize / 2);
+
+    NewInstance();
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Verify(&instance), 0);
+    serialNumber = 0;
+    EXPECT_EQ(BoardConfigInstance_Get_Factory_SerialNumber(&instance, &serialNumber), 0);
+    EXPECT_EQ(serialNumber, 0xCAFEu);
+}
+
+TEST_F(GivenBoardConfigMedium, WhenWriteOutOfRangeThenItShouldFailInAndOutOfTransaction)
+{
+    uint8_t data[2] = {0};
+    ASSERT_EQ(BoardConfigInstance_Init(&instance, &config), 0);
+    EXPECT_EQ(BoardConfigInstance_Write(&instance, kBoardConfigTotalSize - 1, data, sizeof(data)), -1);
+    EXPECT_EQ(BoardConfigInstance_Write(&instance, 0, NULL, sizeof(data)), -1);
+    ASSERT_EQ(BoardConfigInstance_Begin(&instance), 0);
+    EXPECT_EQ(BoardConfigInstance_Write(&instance, kBoardConfigTotalSize - 1, data, sizeof(data)), -1);
+    EXPECT_EQ(BoardConfigInstance_End(&instance), 0);
+}
@@ -0,0 +1,35 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef BOARDCONFIGUSER_H_
+#define BOARDCONFIGUSER_H_
+
+// Test schema for boardconfigschema.h.
+#define kBoardConfigSchemaSections(mSection) \
+    mSection(Factory) \
+    mSection(User)
+
+#define kBoardConfigSchema_Factory(mField) \
+    mField(Factory, SerialNumber, uint32_t, 0x12345678) \
+    mField(Factory, HardwareRevision, uint8_t, 3)
+
+#define kBoardConfigSchema_User(mField) \
+    mField(User, DisplayBrightness, uint8_t, 80) \
+    mField(User, CurrentLimit, int32_t, 300)
+
+#endif // BOARDCONFIGUSER_H_
@@ -0,0 +1,239 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "conversion.h"
+};
+
+struct DecodeParameters {
+    uint16_t multiplier;
+    uint8_t scale;
+    int8_t sign;
+};
+
+class GivenDecodeParameters : public ::testing::TestWithParam<DecodeParameters>{
+};
+
+TEST_P(GivenDecodeParameters, WhenAllValuesDecodedInBatchThenShouldMatchScalar){
+    const DecodeParameters parameters = GetParam();
+    std::vector<uint16_t> input(UINT16_MAX + 1);
+    std::vector<uint16_t> output(input.size());
+
+    for (uint32_t value = 0; value <= UINT16_MAX; value ++)
+    {
+        input[value] = value;
+    }
+
+    ConversionDecodeBatch(input.data(), output.data(), input.size(), parameters.multiplier, parameters.scale, parameters.sign);
+
+    for (uint32_t value = 0; value <= UINT16_MAX; value ++)
+    {
+        ASSERT_EQ(output[value], ConversionDecode(value, parameters.multiplier, parameters.scale, parameters.sign)) << "value " << value;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ConversionDecodeBatch, GivenDecodeParameters, ::testing::Values(
+        DecodeParameters{4801, 16, 1},
+        DecodeParameters{4801, 16, -1},
+        DecodeParameters{1, 1, 1},
+        DecodeParameters{32767, 1, 1},
+        DecodeParameters{32767, 15, -1},
+        DecodeParameters{1000, 4, -1},
+        DecodeParameters{1000, 0, 1},
+        DecodeParameters{0, 8, -1}
+        ));
+
+class GivenEncodeParameters : public ::testing::TestWithParam<DecodeParameters>{
+};
+
+TEST_P(GivenEncodeParameters, WhenThresholdEncodedThenShouldSplitDecodedValues){
+    const DecodeParameters parameters = GetParam();
+    const uint16_t limits[] = {0, 1, 2, 150, 299, 300, 301, 4095, 32767, UINT16_MAX - 1, UINT16_MAX};
+
+    for (uint16_t limit : limits)
+    {
+        uint16_t threshold;
+        ASSERT_EQ(ConversionEncode(limit, parameters.multiplier, parameters.scale, parameters.sign, &threshold), 0);
+
+        for (uint32_t value = 0; value <= UINT16_MAX; value ++)
+        {
+            bool decodedAbove = ConversionDecode(value, parameters.multiplier, parameters.scale, parameters.sign) > limit;
+            ASSERT_EQ(decodedAbove, value > threshold) << "limit " << limit << " value " << value;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ConversionEncode, GivenEncodeParameters, ::testing::Values(
+        DecodeParameters{4801, 16, 1},
+        DecodeParameters{1, 1, 1},
+        DecodeParameters{32767, 1, 1},
+        DecodeParameters{1000, 4, 1},
+        DecodeParameters{1000, 0, 1},
+        DecodeParameters{0, 8, 1}
+        ));
+
+TEST(GivenNegativeSign, WhenThresholdEncodedThenShouldFail){
+    uint16_t threshold;
+
+    EXPECT_EQ(ConversionEncode(300, 4801, 16, -1, &threshold), -1);
+}
+
+class GivenUntrimmedCalibration : public ::testing::TestWithParam<DecodeParameters>{
+};
+
+TEST_P(GivenUntrimmedCalibration, WhenAllValuesDecodedThenShouldMatchConversionDecode){
+    const DecodeParameters parameters = GetParam();
+    ConversionCalibration_t calibration = {{parameters.multiplier, parameters.scale, parameters.sign}, 0, 0};
+    ConversionFused_t fused;
+
+    ASSERT_EQ(ConversionFuse(&calibration, &fused), 0);
+
+    for (uint32_t value = 0; value <= UINT16_MAX; value ++)
+    {
+        ASSERT_EQ(ConversionDecodeFused(value, &fused), ConversionDecode(value, parameters.multiplier, parameters.scale, parameters.sign)) << "value " << value;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ConversionDecodeFused, GivenUntrimmedCalibration, ::testing::Values(
+        DecodeParameters{4801, 16, 1},
+        DecodeParameters{4801, 16, -1},
+        DecodeParameters{1, 1, 1},
+        DecodeParameters{1000, 4, -1},
+        DecodeParameters{0, 8, 1}
+        ));
+
+struct CalibrationParameters {
+    int16_t offset;
+    int16_t gainTrim;
+};
+
+class GivenTrimmedCalibration : public ::testing::TestWithParam<CalibrationParameters>{
+};
+
+TEST_P(GivenTrimmedCalibration, WhenDecodedThenShouldMatchReferenceAndEncodeThresholds){
+    const CalibrationParameters parameters = GetParam();
+    ConversionCalibration_t calibration = {{4801, 16, 1}, parameters.offset, parameters.gainTrim};
+    ConversionFused_t fused;
+
+    ASSERT_EQ(ConversionFuse(&calibration, &fused), 0);
+
+    for (uint32_t value = 0; value < 4096; value ++)
+    {
+        double reference = value * 4801.0 / 65536.0 * (1.0 + parameters.gainTrim / 32768.0) + parameters.offset;
+        reference = std::min(std::max(reference, 0.0), (double)UINT16_MAX);
+        // Rounding, plus the fused multiplier resolution (15 bits).
+        ASSERT_NEAR(ConversionDecodeFused(value, &fused), reference, 0.5 + reference / 16384.0) << "value " << value;
+    }
+
+    const uint16_t limits[] = {0, 1, 150, 300, 301, 4095, UINT16_MAX};
+    for (uint16_t limit : limits)
+    {
+        uint16_t threshold;
+        if (ConversionEncodeFused(limit, &fused, &threshold) != 0)
+        {
+            // Only limits below the value of 0 have no threshold.
+            ASSERT_GT(ConversionDecodeFused(0, &fused), limit);
+            continue;
+        }
+
+        for (uint32_t value = 0; value <= UINT16_MAX; value ++)
+        {
+            bool decodedAbove = ConversionDecodeFused(value, &fused) > limit;
+            ASSERT_EQ(decodedAbove, value > threshold) << "limit " << limit << " value " << value;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ConversionFuse, GivenTrimmedCalibration, ::testing::Values(
+        CalibrationParameters{0, 0},
+        CalibrationParameters{0, 1000},
+        CalibrationParameters{0, -1000},
+        CalibrationParameters{-5, 328},
+        CalibrationParameters{7, -32768},
+        CalibrationParameters{200, 32767}
+        ));
+
+TEST(GivenEmptyBatch, WhenDecodedThenShouldNotWrite){
+    uint16_t output = 0xA5A5;
+
+    ConversionDecodeBatch(NULL, &output, 0, 4801, 16, 1);
+    EXPECT_EQ(output, 0xA5A5);
+}
+
+TEST(GivenTable, WhenAmplitudeComputedThenShouldReturnMinAndMax){
+    uint16_t table[] = {300, 12, 4095, 12, 800};
+    uint16_t minValue;
+    uint16_t maxValue;
+
+    EXPECT_EQ(ComputeAmplitude(table, 5, &minValue, &maxValue), 4095 - 12);
+    EXPECT_EQ(minValue, 12);
+    EXPECT_EQ(maxValue, 4095);
+}
+
+class GivenAmplitudeWindow : public ::testing::TestWithParam<uint16_t>{
+};
+
+TEST_P(GivenAmplitudeWindow, WhenSamplesPushedThenShouldMatchAmplitudeOfLastSamples){
+    const uint16_t windowSize = GetParam();
+    std::vector<ConversionAmplitudeEntry_t> minEntries(windowSize);
+    std::vector<ConversionAmplitudeEntry_t> maxEntries(windowSize);
+    std::vector<uint16_t> samples;
+    ConversionAmplitudeWindow_t window;
+    std::mt19937 generator(windowSize);
+
+    EXPECT_EQ(ConversionAmplitudeWindowInit(&window, minEntries.data(), maxEntries.data(), windowSize), 0);
+
+    for (uint32_t sampleIdx = 0; sampleIdx < 2000; sampleIdx ++)
+    {
+        // Mix of noise and ramps, ramps fill the deques.
+        uint16_t sample = (sampleIdx / 200) & 1 ? (sampleIdx * 7) & 0x0FFF : generator() & 0x0FFF;
+        samples.push_back(sample);
+
+        uint16_t minValue;
+        uint16_t maxValue;
+        uint16_t amplitude = ConversionAmplitudeWindowPush(&window, sample, &minValue, &maxValue);
+
+        uint16_t first = (samples.size() > windowSize) ? samples.size() - windowSize : 0;
+        uint16_t expectedMin;
+        uint16_t expectedMax;
+        uint16_t expected = ComputeAmplitude(&samples[first], samples.size() - first, &expectedMin, &expectedMax);
+
+        ASSERT_EQ(amplitude, expected) << "sample " << sampleIdx;
+        ASSERT_EQ(minValue, expectedMin) << "sample " << sampleIdx;
+        ASSERT_EQ(maxValue, expectedMax) << "sample " << sampleIdx;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ConversionAmplitudeWindow, GivenAmplitudeWindow, ::testing::Values(1, 2, 7, 64));
+
+TEST(GivenEmptyAmplitudeWindow, WhenInitAndSamplePushedThenShouldFailAndStoreNothing){
+    ConversionAmplitudeWindow_t window;
+    uint16_t minValue;
+    uint16_t maxValue;
+
+    EXPECT_EQ(ConversionAmplitudeWindowInit(&window, NULL, NULL, 0), -1);
+    EXPECT_EQ(ConversionAmplitudeWindowPush(&window, 300, &minValue, &maxValue), 0);
+    EXPECT_EQ(minValue, 300);
+    EXPECT_EQ(maxValue, 300);
+}
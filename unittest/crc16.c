@@ -0,0 +1,32 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include "crc16.h"
+
+uint16_t CRC16ComputeCRC(uint16_t inCRC, uint8_t* inData, uint32_t inSize)
+{
+    while (inSize--)
+    {
+        inCRC ^= (uint16_t)(*inData++) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            inCRC = (inCRC & 0x8000) ? (uint16_t)((inCRC << 1) ^ 0x1021) : (uint16_t)(inCRC << 1);
+        }
+    }
+    return inCRC;
+}
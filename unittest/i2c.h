@@ -0,0 +1,37 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef I2C_H_
+#define I2C_H_
+
+// Test replacement for the project i2c.h, implemented by the ADC128D818 simulator (adc128d818sim.c).
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int I2CReadRegister(uint8_t inAddress, uint8_t inRegister, uint8_t* outData, uint16_t inSize);
+int I2CWriteRegister(uint8_t inAddress, uint8_t inRegister, uint8_t* inData, uint16_t inSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2C_H_
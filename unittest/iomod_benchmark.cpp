@@ -0,0 +1,129 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+// Bus usage of the IOMod scan against simulated ADC128D818 slaves: bus time, reads, stale reads (no new conversion
+// since the previous read) and mean age of the readings, per simulated second. Then the schedule picked for one channel
+// of one slave per needed period, with the conversions done.
+
+#include <cstdio>
+#include <initializer_list>
+
+extern "C" {
+#include "iomod.h"
+#include "adc128d818sim.h"
+#include "utils.h"
+};
+
+static const uint32_t kDurationUs = 10000000;
+
+extern "C" {
+void DelayUs(uint32_t inUs)
+{
+    ADC128D818SimAdvance(inUs);
+}
+
+uint32_t GetTimeUs(void)
+{
+    return (uint32_t)ADC128D818SimGetTimeUs();
+}
+
+void AssertFailure(const uint8_t* inFile, uint32_t inLine, const char* inFunction)
+{
+    printf("Assert in %s (%s:%u)\n", inFunction, (const char*)inFile, inLine);
+}
+
+int BoardConfig_Read(uint32_t inAddress, uint8_t* outData, uint32_t inSize)
+{
+    (void)inAddress;
+    (void)outData;
+    (void)inSize;
+
+    return -1;
+}
+};
+
+int main()
+{
+    for (uint8_t slaveCount : {(uint8_t)1, (uint8_t)kIOModSlavesPerBus})
+    {
+        for (uint32_t periodUs : {1000u, 10000u, 100000u})
+        {
+            ADC128D818SimBusStats_t before;
+            ADC128D818SimBusStats_t after;
+
+            ADC128D818SimReset();
+            for (uint8_t slaveID = 0; slaveID < slaveCount; slaveID ++)
+            {
+                ADC128D818SimAddDevice(IOModGetADCDevice(slaveID));
+            }
+            IOModDiscover();
+            for (uint8_t slaveID = 0; slaveID < slaveCount; slaveID ++)
+            {
+                IOModADCInit(slaveID);
+            }
+
+            ADC128D818SimGetBusStats(0, &before);
+            uint64_t startUs = ADC128D818SimGetTimeUs();
+            // The scan reads one slave of the bus per call.
+            while (ADC128D818SimGetTimeUs() - startUs < kDurationUs)
+            {
+                uint64_t scanUs = ADC128D818SimGetTimeUs();
+                IOModScanProcess((uint32_t)scanUs);
+                uint64_t elapsedUs = ADC128D818SimGetTimeUs() - scanUs;
+                ADC128D818SimAdvance((elapsedUs < periodUs) ? (uint32_t)(periodUs - elapsedUs) : 0);
+            }
+            ADC128D818SimGetBusStats(0, &after);
+
+            double seconds = (ADC128D818SimGetTimeUs() - startUs) / 1e6;
+            uint32_t readingReads = after.readingReads - before.readingReads;
+            printf("%u slave(s), scan every %u us: bus %.1f %%, %.0f reads/s, %.0f stale reads/s, reading age %.1f ms\n",
+                   slaveCount, periodUs, (after.busUs - before.busUs) / (seconds * 1e4), (after.reads - before.reads) / seconds,
+                   (after.staleReadingReads - before.staleReadingReads) / seconds,
+                   readingReads ? (after.readingAgeUs - before.readingAgeUs) / (readingReads * 1e3) : 0.0);
+        }
+    }
+
+    for (uint32_t periodUs : {100000u, 1000000u, 5000000u})
+    {
+        IOModSchedule_t schedule;
+        uint16_t adcDevice = IOModGetADCDevice(0);
+
+        ADC128D818SimReset();
+        ADC128D818SimAddDevice(adcDevice);
+        IOModDiscover();
+        for (uint8_t channelIdx = 0; channelIdx < kIOModChannelsPerSlave; channelIdx ++)
+        {
+            IOModSetChannelPeriod(0, channelIdx, (channelIdx == 0) ? periodUs : 0);
+        }
+        IOModADCInit(0);
+
+        uint64_t startUs = ADC128D818SimGetTimeUs();
+        while (ADC128D818SimGetTimeUs() - startUs < kDurationUs)
+        {
+            IOModScanProcess((uint32_t)ADC128D818SimGetTimeUs());
+            ADC128D818SimAdvance(10000);
+        }
+        IOModGetSchedule(0, &schedule);
+
+        double seconds = (ADC128D818SimGetTimeUs() - startUs) / 1e6;
+        printf("1 channel every %u us: mode %u, period %u us, duty cycle %.2f %%, %.1f conversions/s\n", periodUs,
+               schedule.mode, schedule.periodUs, schedule.dutyCyclePpm / 1e4, ADC128D818SimGetConversionCount(adcDevice) / seconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "iomod.h"
+#include "iomodbus.h"
+#include "adc128d818.h"
+#include "adc128d818sim.h"
+#include "utils.h"
+};
+
+// Built with kIOModBusMax = 2, a slave at the same address on each bus.
+static_assert(kIOModBusMax == 2, "Two buses expected");
+
+// Hooks of the library, on the simulated time.
+extern "C" {
+void DelayUs(uint32_t inUs)
+{
+    ADC128D818SimAdvance(inUs);
+}
+
+uint32_t GetTimeUs(void)
+{
+    return (uint32_t)ADC128D818SimGetTimeUs();
+}
+
+void AssertFailure(const uint8_t* inFile, uint32_t inLine, const char* inFunction)
+{
+    ADD_FAILURE() << "Assert in " << inFunction << " (" << inFile << ":" << inLine << ")";
+}
+
+int BoardConfig_Read(uint32_t inAddress, uint8_t* outData, uint32_t inSize)
+{
+    (void)inAddress;
+    (void)outData;
+    (void)inSize;
+
+    return -1;
+}
+};
+
+static const uint8_t kSlaveIDs[kIOModBusMax] = { 0, kIOModSlavesPerBus };
+
+static uint32_t NowUs()
+{
+    return (uint32_t)ADC128D818SimGetTimeUs();
+}
+
+static void OnScanDone(IOModPortStatus_e inStatus, void* inContext)
+{
+    *(IOModPortStatus_e*)inContext = inStatus;
+}
+
+// IOMod keeps its state between tests, each test starts from a discovery and init of both simulated slaves.
+class GivenSlavesOnTwoBuses : public ::testing::Test{
+    protected:
+        GivenSlavesOnTwoBuses(){
+            ADC128D818SimReset();
+            for (uint8_t busID = 0; busID < kIOModBusMax; busID ++)
+            {
+                IOModBusPort_t port;
+                ADC128D818SimGetPort(busID, &port);
+                IOModBusInit(busID, &port);
+
+                uint8_t slaveID = kSlaveIDs[busID];
+                devices[busID] = IOModGetADCDevice(slaveID);
+                ADC128D818SimAddDevice(devices[busID]);
+                IOModSetChannelMask(slaveID, 0xFF);
+                for (uint8_t channelIdx = 0; channelIdx < kIOModChannelsPerSlave; channelIdx ++)
+                {
+                    IOModSetChannelPeriod(slaveID, channelIdx, 0);
+                }
+            }
+            EXPECT_EQ(IOModDiscover(), kIOModPortStatus_Valid);
+            for (uint8_t busID = 0; busID < kIOModBusMax; busID ++)
+            {
+                EXPECT_EQ(IOModADCInit(kSlaveIDs[busID]), kIOModPortStatus_Valid);
+            }
+        }
+
+        uint32_t ReadingReads(uint8_t inBusID){
+            ADC128D818SimBusStats_t stats;
+            ADC128D818SimGetBusStats(inBusID, &stats);
+            return stats.readingReads;
+        }
+
+        uint32_t Writes(uint8_t inBusID){
+            ADC128D818SimBusStats_t stats;
+            ADC128D818SimGetBusStats(inBusID, &stats);
+            return stats.writes;
+        }
+
+        uint16_t devices[kIOModBusMax];
+};
+
+TEST_F(GivenSlavesOnTwoBuses, WhenDiscoverThenSlavesShouldBeRoutedToTheirBus){
+    EXPECT_EQ(devices[0], mIOModBusDevice(0, kADC128D818_SlaveAddress1));
+    EXPECT_EQ(devices[1], mIOModBusDevice(1, kADC128D818_SlaveAddress1));
+    EXPECT_EQ(IOModGetADCDevice(kIOModSlavesPerBus + 1), mIOModBusDevice(1, kADC128D818_SlaveAddress2));
+
+    EXPECT_TRUE(IOModIsPresent(kSlaveIDs[0]));
+    EXPECT_TRUE(IOModIsPresent(kSlaveIDs[1]));
+    EXPECT_FALSE(IOModIsPresent(kSlaveIDs[0] + 1));
+    EXPECT_FALSE(IOModIsPresent(kSlaveIDs[1] + 1));
+}
+
+TEST_F(GivenSlavesOnTwoBuses, WhenBusScannedThenOnlyItsSlaveShouldBeRead){
+    IOModSample_t sample;
+
+    ADC128D818SimSetInput(devices[0], 2, 1000);
+    ADC128D818SimSetInput(devices[1], 2, 3000);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveIDs[1]));
+
+    uint32_t bus0Reads = ReadingReads(0);
+    EXPECT_EQ(IOModScanProcessBus(1, NowUs()), kIOModPortStatus_Valid);
+    EXPECT_EQ(ReadingReads(0), bus0Reads);
+    EXPECT_GT(ReadingReads(1), 0u);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveIDs[1], 2, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 3000);
+
+    uint32_t bus1Reads = ReadingReads(1);
+    EXPECT_EQ(IOModScanProcessBus(0, NowUs()), kIOModPortStatus_Valid);
+    EXPECT_EQ(ReadingReads(1), bus1Reads);
+    EXPECT_GT(ReadingReads(0), bus0Reads);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveIDs[0], 2, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 1000);
+}
+
+TEST_F(GivenSlavesOnTwoBuses, WhenScanSubmittedThenEachBusShouldTransferItsPart){
+    IOModPortStatus_e scanStatus = kIOModPortStatus_Pending;
+    IOModSample_t sample;
+
+    ADC128D818SimSetInput(devices[0], 5, 1500);
+    ADC128D818SimSetInput(devices[1], 5, 2500);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveIDs[0]) * 2);
+
+    EXPECT_EQ(IOModScanSubmit(NowUs(), OnScanDone, &scanStatus), kIOModPortStatus_Valid);
+    EXPECT_FALSE(IOModBusIdle(0));
+    EXPECT_FALSE(IOModBusIdle(1));
+
+    // Bus 1 done, the batch waits for bus 0.
+    EXPECT_EQ(IOModBusProcess(1), kIOModChannelsPerSlave);
+    EXPECT_TRUE(IOModBusIdle(1));
+    EXPECT_FALSE(IOModBusIdle(0));
+    EXPECT_EQ(scanStatus, kIOModPortStatus_Pending);
+    EXPECT_EQ(IOModScanSubmit(NowUs(), OnScanDone, &scanStatus), kIOModPortStatus_Pending);
+
+    EXPECT_EQ(IOModBusProcess(0), kIOModChannelsPerSlave);
+    EXPECT_EQ(scanStatus, kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveIDs[0], 5, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 1500);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveIDs[1], 5, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 2500);
+}
+
+TEST_F(GivenSlavesOnTwoBuses, WhenSameAddressOnBothBusesThenRegisterCachesShouldBeSeparate){
+    uint8_t channelDisable;
+
+    // Slave of bus 0 only.
+    uint32_t bus1Writes = Writes(1);
+    EXPECT_EQ(IOModSetChannelMask(kSlaveIDs[0], 0x0F), kIOModPortStatus_Valid);
+    EXPECT_EQ(Writes(1), bus1Writes);
+    EXPECT_EQ(ADC128D818SimReadRegister(devices[0], kADC128D818_RegisterChannelDisable, &channelDisable, 1), 0);
+    EXPECT_EQ(channelDisable, 0xF0);
+    EXPECT_EQ(ADC128D818SimReadRegister(devices[1], kADC128D818_RegisterChannelDisable, &channelDisable, 1), 0);
+    EXPECT_EQ(channelDisable, 0x00);
+
+    // Not skipped as cached by the slave of bus 0.
+    EXPECT_EQ(IOModSetChannelMask(kSlaveIDs[1], 0x0F), kIOModPortStatus_Valid);
+    EXPECT_GT(Writes(1), bus1Writes);
+    EXPECT_EQ(ADC128D818SimReadRegister(devices[1], kADC128D818_RegisterChannelDisable, &channelDisable, 1), 0);
+    EXPECT_EQ(channelDisable, 0xF0);
+}
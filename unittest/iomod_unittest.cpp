@@ -0,0 +1,928 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "iomod.h"
+#include "iomodbus.h"
+#include "adc128d818.h"
+#include "adc128d818sim.h"
+#include "utils.h"
+};
+
+// Simulated time spent by each GetTimeUs, to let the busy waits without bus transfers time out.
+static uint32_t gTimeStepUs;
+
+// Hooks of the library, on the simulated time.
+extern "C" {
+void DelayUs(uint32_t inUs)
+{
+    ADC128D818SimAdvance(inUs);
+}
+
+uint32_t GetTimeUs(void)
+{
+    ADC128D818SimAdvance(gTimeStepUs);
+    return (uint32_t)ADC128D818SimGetTimeUs();
+}
+
+void AssertFailure(const uint8_t* inFile, uint32_t inLine, const char* inFunction)
+{
+    ADD_FAILURE() << "Assert in " << inFunction << " (" << inFile << ":" << inLine << ")";
+}
+};
+
+// Board config with only the calibrations, at kCalibrationsAddress, read by parts.
+static const uint32_t kCalibrationsAddress = 0x100;
+static IOModCalibrations_t gCalibrations;
+
+extern "C" {
+int BoardConfig_Read(uint32_t inAddress, uint8_t* outData, uint32_t inSize)
+{
+    if ((inAddress < kCalibrationsAddress) || (inAddress + inSize > kCalibrationsAddress + sizeof(gCalibrations)))
+    {
+        return -1;
+    }
+
+    memcpy(outData, (uint8_t*)&gCalibrations + (inAddress - kCalibrationsAddress), inSize);
+
+    return 0;
+}
+};
+
+static const uint8_t kSlaveID = 0;
+
+static uint32_t NowUs()
+{
+    return (uint32_t)ADC128D818SimGetTimeUs();
+}
+
+static void OnAlert(uint8_t inSlaveID, uint8_t inChannelMask, void* inContext)
+{
+    uint16_t* alert = (uint16_t*)inContext;
+
+    *alert = (uint16_t)((inSlaveID << 8) | inChannelMask);
+}
+
+static void OnScanDone(IOModPortStatus_e inStatus, void* inContext)
+{
+    *(IOModPortStatus_e*)inContext = inStatus;
+}
+
+// IOMod keeps its state between tests, each test starts from a discovery and init of one simulated slave.
+class GivenSimulatedSlave : public ::testing::Test{
+    protected:
+        GivenSimulatedSlave(){
+            ADC128D818SimReset();
+            device = IOModGetADCDevice(kSlaveID);
+            ADC128D818SimAddDevice(device);
+            IOModSetChannelMask(kSlaveID, 0xFF);
+            for (uint8_t channelIdx = 0; channelIdx < kIOModChannelsPerSlave; channelIdx ++)
+            {
+                IOModSetChannelPeriod(kSlaveID, channelIdx, 0);
+            }
+            IOModScanInternalTemperature(kSlaveID, 0);
+            IOModEnableAlerts(kSlaveID, 0);
+            IOModSetAlertCallback(NULL, NULL);
+            EXPECT_EQ(IOModDiscover(), kIOModPortStatus_Valid);
+            EXPECT_EQ(IOModADCInit(kSlaveID), kIOModPortStatus_Valid);
+        }
+
+        // Convert inCode on a channel and scan it.
+        void ScanInput(uint8_t inChannelIdx, uint16_t inCode){
+            ADC128D818SimSetInput(device, inChannelIdx, inCode);
+            ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+            EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+        }
+
+        // Scan every inPeriodUs for inDurationUs, returns the conversions done.
+        uint32_t Scan(uint32_t inDurationUs, uint32_t inPeriodUs){
+            uint32_t count = ADC128D818SimGetConversionCount(device);
+            uint64_t startUs = ADC128D818SimGetTimeUs();
+
+            while (ADC128D818SimGetTimeUs() - startUs < inDurationUs)
+            {
+                EXPECT_NE(IOModScanProcess(NowUs()), kIOModPortStatus_DriverBusError);
+                ADC128D818SimAdvance(inPeriodUs);
+            }
+
+            return ADC128D818SimGetConversionCount(device) - count;
+        }
+
+        uint16_t device;
+};
+
+TEST_F(GivenSimulatedSlave, WhenDiscoverThenOnlySimulatedSlaveShouldBePresent){
+    int32_t value;
+
+    EXPECT_TRUE(IOModIsPresent(kSlaveID));
+    EXPECT_FALSE(IOModIsPresent(kSlaveID + 1));
+    EXPECT_EQ(IOModGetCurrent(kSlaveID + 1, 0, &value), kIOModPortStatus_NotDetected);
+}
+
+static int StartNever(IOModBusTransaction_t* inTransaction, void* inContext)
+{
+    return 0;
+}
+
+TEST_F(GivenSimulatedSlave, WhenProbesNeverCompleteThenDiscoverShouldTimeOutAndDropTheSlaves){
+    IOModBusPort_t port = {};
+    int32_t value;
+
+    // Completion interrupt lost.
+    port.start = StartNever;
+    IOModBusInit(0, &port);
+    gTimeStepUs = 1000;
+    uint64_t startUs = ADC128D818SimGetTimeUs();
+    EXPECT_EQ(IOModDiscover(), kIOModPortStatus_NotDetected);
+    EXPECT_LT(ADC128D818SimGetTimeUs() - startUs, kIOModDiscoverTimeoutUs + 10 * gTimeStepUs);
+    EXPECT_FALSE(IOModIsPresent(kSlaveID));
+    // Not submitted again while queued.
+    EXPECT_EQ(IOModDiscover(), kIOModPortStatus_Pending);
+    gTimeStepUs = 0;
+
+    // Initialized slave out of the scan.
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_NotDetected);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 0, &value), kIOModPortStatus_NotDetected);
+
+    // Found again once the bus recovers.
+    port.start = NULL;
+    IOModBusInit(0, &port);
+    EXPECT_EQ(IOModDiscover(), kIOModPortStatus_Valid);
+    EXPECT_TRUE(IOModIsPresent(kSlaveID));
+}
+
+TEST_F(GivenSimulatedSlave, WhenSlaveNotInitializedThenItShouldNotBeProgrammed){
+    ADC128D818SimBusStats_t before;
+    ADC128D818SimBusStats_t after;
+
+    // Present, its device is not known before IOModADCInit.
+    ADC128D818SimAddDevice(IOModGetADCDevice(kSlaveID + 1));
+    EXPECT_EQ(IOModDiscover(), kIOModPortStatus_Valid);
+    EXPECT_TRUE(IOModIsPresent(kSlaveID + 1));
+
+    ADC128D818SimGetBusStats(0, &before);
+    EXPECT_EQ(IOModSetChannelLimits(kSlaveID + 1, 0, 0, 100), kIOModPortStatus_NotDetected);
+    EXPECT_EQ(IOModEnableAlerts(kSlaveID + 1, 0x01), kIOModPortStatus_NotDetected);
+    EXPECT_EQ(IOModInternalTemperatureStart(kSlaveID + 1, NowUs()), kIOModPortStatus_NotDetected);
+    ADC128D818SimGetBusStats(0, &after);
+    EXPECT_EQ(after.writes, before.writes);
+}
+
+TEST_F(GivenSimulatedSlave, WhenNotReadyThenInitShouldFail){
+    ADC128D818SimPowerCycle(device);
+    EXPECT_NE(IOModADCInit(kSlaveID), kIOModPortStatus_Valid);
+
+    ADC128D818SimAdvance(kADC128D818_PowerUpUs);
+    EXPECT_EQ(IOModADCInit(kSlaveID), kIOModPortStatus_Valid);
+}
+
+TEST_F(GivenSimulatedSlave, WhenCycleElapsedThenShouldReturnInputCurrent){
+    int32_t value;
+
+    ADC128D818SimSetInput(device, 2, 2048);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+
+    // 2048 * 4801 / 2^16.
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+}
+
+TEST_F(GivenSimulatedSlave, WhenInputChangesThenNextCycleShouldReturnNewInput){
+    IOModSample_t sample;
+
+    ADC128D818SimSetInput(device, 0, 1000);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    IOModScanProcess(NowUs());
+    ADC128D818SimSetInput(device, 0, 3000);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    IOModScanProcess(NowUs());
+
+    EXPECT_EQ(IOModGetLatestSample(kSlaveID, 0, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 3000);
+}
+
+TEST_F(GivenSimulatedSlave, WhenScanningFasterThanConversionsThenShouldNotReadStaleReadings){
+    ADC128D818SimBusStats_t stats;
+
+    for (uint32_t scanIdx = 0; scanIdx < 1000; scanIdx ++)
+    {
+        IOModScanProcess(NowUs());
+        ADC128D818SimAdvance(1000);
+    }
+
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_GT(stats.readingReads, 0u);
+    EXPECT_EQ(stats.staleReadingReads, 0u);
+}
+
+TEST_F(GivenSimulatedSlave, WhenScanStoppedThenGettersShouldReadTheSlaveOnceTheSampleIsStale){
+    ADC128D818SimBusStats_t stats;
+    int32_t value;
+
+    ADC128D818SimSetInput(device, 2, 2048);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    ADC128D818SimSetInput(device, 2, 4000);
+
+    // Recent sample, no bus access.
+    ADC128D818SimGetBusStats(0, &stats);
+    uint32_t reads = stats.reads;
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.reads, reads);
+
+    // Older than the time between conversions plus one round robin: 4000 * 4801 / 2^16.
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID) + 1);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 293);
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_GT(stats.reads, reads);
+}
+
+TEST_F(GivenSimulatedSlave, WhenChannelHasPeriodThenSampleShouldBeUsedForThePeriod){
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 2, 500000), kIOModPortStatus_Valid);
+    ADC128D818SimSetInput(device, 2, 2048);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    ADC128D818SimSetInput(device, 2, 4000);
+
+    ADC128D818SimAdvance(500000);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID) + 1);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 293);
+}
+
+TEST_F(GivenSimulatedSlave, WhenChannelsDisabledThenCycleShouldBeShorter){
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 0x01), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetConversionCycleUs(kSlaveID), (uint32_t)kADC128D818_VoltageConversionUs);
+
+    uint32_t count = ADC128D818SimGetConversionCount(device);
+    ADC128D818SimAdvance(1000000);
+    count = ADC128D818SimGetConversionCount(device) - count;
+
+    EXPECT_GE(count, 1000000u / kADC128D818_VoltageConversionUs);
+    EXPECT_LE(count, 1000000u / kADC128D818_VoltageConversionUs + 1);
+}
+
+TEST_F(GivenSimulatedSlave, WhenInputOverLimitThenShouldRaiseAlert){
+    uint16_t alert = 0;
+
+    IOModSetAlertCallback(OnAlert, &alert);
+    EXPECT_EQ(IOModSetChannelLimits(kSlaveID, 3, 0, 0x07FF), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModEnableAlerts(kSlaveID, 1 << 3), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModHandleAlert(0), kIOModPortStatus_NotDetected);
+    EXPECT_FALSE(ADC128D818SimIsINTAsserted(device));
+
+    ADC128D818SimSetInput(device, 3, 0x0900);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_TRUE(ADC128D818SimIsINTAsserted(device));
+
+    EXPECT_EQ(IOModHandleAlert(0), kIOModPortStatus_Valid);
+    EXPECT_EQ(alert, (kSlaveID << 8) | (1 << 3));
+    EXPECT_FALSE(ADC128D818SimIsINTAsserted(device));
+}
+
+TEST_F(GivenSimulatedSlave, WhenBlockingInternalTemperatureThenShouldReturnSimulatedTemperature){
+    int32_t value;
+
+    // A full round robin is longer than the settling time, convert IN7 only.
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 1 << kADC128D818_IN7), kIOModPortStatus_Valid);
+    ADC128D818SimSetTemperature(device, 25500);
+
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 25500);
+
+    ADC128D818SimSetTemperature(device, -10000);
+    ADC128D818SimAdvance(kIOModInternalTemperatureSettleUs);
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, -10000);
+}
+
+TEST_F(GivenSimulatedSlave, WhenBlockingInternalTemperatureThenScanShouldSkipIN7UntilRestored){
+    IOModSample_t sample;
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 1 << kADC128D818_IN7), kIOModPortStatus_Valid);
+    ADC128D818SimSetTemperature(device, 25500);
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Valid);
+
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    uint32_t scanUs = NowUs();
+    EXPECT_EQ(IOModScanProcess(scanUs), kIOModPortStatus_Valid);
+    EXPECT_TRUE((IOModGetLatestSample(kSlaveID, kADC128D818_IN7, &sample) != kIOModPortStatus_Valid) || (sample.timestampUs != scanUs));
+    ADC128D818SimAdvance(kIOModInternalTemperatureSettleUs);
+    scanUs = NowUs();
+    EXPECT_EQ(IOModScanProcess(scanUs), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveID, kADC128D818_IN7, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.timestampUs, scanUs);
+}
+
+TEST_F(GivenSimulatedSlave, WhenSlaveOutOfRangeThenInternalTemperatureShouldNotBeDetected){
+    int32_t value;
+
+    EXPECT_EQ(IOModGetInternalTemperature(kIOModMaxSlaves, &value), kIOModPortStatus_NotDetected);
+    EXPECT_EQ(IOModInternalTemperatureStart(kIOModMaxSlaves, NowUs()), kIOModPortStatus_NotDetected);
+    EXPECT_EQ(IOModInternalTemperaturePoll(kIOModMaxSlaves, NowUs(), &value), kIOModPortStatus_NotDetected);
+}
+
+TEST_F(GivenSimulatedSlave, WhenInternalTemperatureStartedThenPollShouldReturnItOnceSettled){
+    uint8_t mode;
+    uint8_t previousMode;
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 1 << kADC128D818_IN7), kIOModPortStatus_Valid);
+    ADC128D818SimSetTemperature(device, 25500);
+    EXPECT_EQ(ADC128D818GetMode(device, &previousMode), 0);
+    EXPECT_EQ(IOModInternalTemperaturePoll(kSlaveID, NowUs(), &value), kIOModPortStatus_InvalidRange);
+
+    uint32_t startUs = NowUs();
+    EXPECT_EQ(IOModInternalTemperatureStart(kSlaveID, startUs), kIOModPortStatus_Valid);
+    EXPECT_EQ(ADC128D818GetMode(device, &mode), 0);
+    EXPECT_EQ(mode, kADC128D818_Mode_Temp);
+    EXPECT_EQ(IOModInternalTemperatureStart(kSlaveID, startUs), kIOModPortStatus_Pending);
+    EXPECT_EQ(IOModInternalTemperaturePoll(kSlaveID, startUs + kIOModInternalTemperatureSettleUs - 1, &value), kIOModPortStatus_Pending);
+
+    ADC128D818SimAdvance(kIOModInternalTemperatureSettleUs);
+    EXPECT_EQ(IOModInternalTemperaturePoll(kSlaveID, startUs + kIOModInternalTemperatureSettleUs, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 25500);
+    EXPECT_EQ(ADC128D818GetMode(device, &mode), 0);
+    EXPECT_EQ(mode, previousMode);
+
+    // IN7 holds the temperature until the restore settled, the scan skips it until then.
+    IOModSample_t sample;
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    uint32_t scanUs = NowUs();
+    EXPECT_EQ(IOModScanProcess(scanUs), kIOModPortStatus_Valid);
+    EXPECT_TRUE((IOModGetLatestSample(kSlaveID, kADC128D818_IN7, &sample) != kIOModPortStatus_Valid) || (sample.timestampUs != scanUs));
+    ADC128D818SimAdvance(kIOModInternalTemperatureSettleUs);
+    scanUs = NowUs();
+    EXPECT_EQ(IOModScanProcess(scanUs), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveID, kADC128D818_IN7, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.timestampUs, scanUs);
+}
+
+TEST_F(GivenSimulatedSlave, WhenScanAcquiresInternalTemperatureThenGetterShouldReturnItsValue){
+    ADC128D818SimBusStats_t before;
+    ADC128D818SimBusStats_t after;
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 1 << kADC128D818_IN7), kIOModPortStatus_Valid);
+    ADC128D818SimSetTemperature(device, -5000);
+    IOModScanInternalTemperature(kSlaveID, 1000000);
+    Scan(2 * kIOModInternalTemperatureSettleUs, 5000);
+
+    // No mode switch nor wait.
+    ADC128D818SimGetBusStats(0, &before);
+    uint64_t startUs = ADC128D818SimGetTimeUs();
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, -5000);
+    ADC128D818SimGetBusStats(0, &after);
+    EXPECT_EQ(after.writes, before.writes);
+    EXPECT_EQ(ADC128D818SimGetTimeUs(), startUs);
+}
+
+TEST_F(GivenSimulatedSlave, WhenScanStoppedThenGetterShouldReadTheStaleInternalTemperatureAgain){
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 1 << kADC128D818_IN7), kIOModPortStatus_Valid);
+    ADC128D818SimSetTemperature(device, -5000);
+    IOModScanInternalTemperature(kSlaveID, 1000000);
+    Scan(2 * kIOModInternalTemperatureSettleUs, 5000);
+
+    // Not scanned for more than a period.
+    ADC128D818SimSetTemperature(device, 25500);
+    ADC128D818SimAdvance(2000000);
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 25500);
+
+    // Mode restore left to the scan.
+    IOModScanInternalTemperature(kSlaveID, 0);
+    ADC128D818SimAdvance(kIOModInternalTemperatureSettleUs);
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+}
+
+TEST_F(GivenSimulatedSlave, WhenScanAcquisitionSettlingThenGetterShouldNotTakeItOver){
+    uint8_t mode;
+    uint8_t previousMode;
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 1 << kADC128D818_IN7), kIOModPortStatus_Valid);
+    ADC128D818SimSetTemperature(device, 25500);
+    EXPECT_EQ(ADC128D818GetMode(device, &previousMode), 0);
+    IOModScanInternalTemperature(kSlaveID, 1000000);
+
+    // The scan switched to temperature mode, the getter leaves the acquisition to it.
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Pending);
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Pending);
+
+    // The scan completes it and restores the mode it saved.
+    Scan(2 * kIOModInternalTemperatureSettleUs, 5000);
+    EXPECT_EQ(ADC128D818GetMode(device, &mode), 0);
+    EXPECT_EQ(mode, previousMode);
+    EXPECT_EQ(IOModGetInternalTemperature(kSlaveID, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 25500);
+}
+
+TEST_F(GivenSimulatedSlave, WhenChannelTypeSetThenScanShouldAccumulateItsStatistics){
+    IOModStats_t stats;
+
+    IOModSetChannelType(kSlaveID, 5, kIOModChannelType_Current);
+    EXPECT_EQ(IOModGetChannelStats(kSlaveID, 5, &stats), kIOModPortStatus_NotDetected);
+
+    // 2048 then 4000: 150 and 293 mA.
+    ADC128D818SimSetInput(device, 5, 2048);
+    for (uint8_t scanIdx = 0; scanIdx < 4; scanIdx ++)
+    {
+        ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+        EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    }
+    ADC128D818SimSetInput(device, 5, 4000);
+    for (uint8_t scanIdx = 0; scanIdx < 4; scanIdx ++)
+    {
+        ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+        EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    }
+
+    EXPECT_EQ(IOModGetChannelStats(kSlaveID, 5, &stats), kIOModPortStatus_Valid);
+    EXPECT_EQ(stats.count, 8u);
+    EXPECT_EQ(stats.min, 150);
+    EXPECT_EQ(stats.max, 293);
+    EXPECT_NEAR(stats.mean, (150 + 293) / 2, 1);
+    EXPECT_GT(stats.variance, 0u);
+
+    // Cleared on the next scan, other types are not accounted.
+    IOModResetChannelStats(kSlaveID, 5);
+    EXPECT_EQ(IOModGetChannelStats(kSlaveID, 5, &stats), kIOModPortStatus_NotDetected);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetChannelStats(kSlaveID, 5, &stats), kIOModPortStatus_Valid);
+    EXPECT_EQ(stats.count, 1u);
+    EXPECT_EQ(stats.mean, 293);
+
+    IOModSetChannelType(kSlaveID, 5, kIOModChannelType_None);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetChannelStats(kSlaveID, 5, &stats), kIOModPortStatus_NotDetected);
+}
+
+TEST_F(GivenSimulatedSlave, WhenChannelFilterSetThenScanShouldDecimateItsSamples){
+    IOModFilterConfig_t config = {};
+    IOModFilteredSample_t filtered;
+
+    config.cicOrder = kIOModFilterMaxCICOrder + 1;
+    EXPECT_EQ(IOModSetChannelFilter(kSlaveID, 4, &config), kIOModPortStatus_InvalidRange);
+
+    // Boxcar average of 4 samples, applied on the next scan.
+    config.decimationShift = 2;
+    config.cicOrder = 1;
+    EXPECT_EQ(IOModSetChannelFilter(kSlaveID, 4, &config), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModSetChannelFilter(kSlaveID, 4, &config), kIOModPortStatus_Pending);
+    EXPECT_EQ(IOModGetFiltered(kSlaveID, 4, &filtered), kIOModPortStatus_NotDetected);
+
+    uint16_t inputs[] = { 1000, 2000, 3000, 2000 };
+    uint32_t scanUs = 0;
+    for (uint16_t input : inputs)
+    {
+        EXPECT_EQ(IOModGetFiltered(kSlaveID, 4, &filtered), kIOModPortStatus_NotDetected);
+        ADC128D818SimSetInput(device, 4, input);
+        ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+        scanUs = NowUs();
+        EXPECT_EQ(IOModScanProcess(scanUs), kIOModPortStatus_Valid);
+    }
+
+    EXPECT_EQ(IOModGetFiltered(kSlaveID, 4, &filtered), kIOModPortStatus_Valid);
+    EXPECT_EQ(filtered.value, 2000u << kIOModFilterFractionBits);
+    EXPECT_EQ(filtered.timestampUs, scanUs);
+
+    // The previous output stays until the next scan applies the new configuration, one output per sample.
+    config.decimationShift = 0;
+    EXPECT_EQ(IOModSetChannelFilter(kSlaveID, 4, &config), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetFiltered(kSlaveID, 4, &filtered), kIOModPortStatus_Valid);
+    ADC128D818SimSetInput(device, 4, 3000);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetFiltered(kSlaveID, 4, &filtered), kIOModPortStatus_Valid);
+    EXPECT_EQ(filtered.value, 3000u << kIOModFilterFractionBits);
+}
+
+TEST_F(GivenSimulatedSlave, WhenConfigurationUnchangedThenShouldSkipWrites){
+    ADC128D818SimBusStats_t before;
+    ADC128D818SimBusStats_t after;
+
+    ADC128D818SimGetBusStats(0, &before);
+    EXPECT_EQ(ADC128D818SetMode(device, kADC128D818_Mode_SingleEnded), 0);
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 0xFF), kIOModPortStatus_Valid);
+    ADC128D818SimGetBusStats(0, &after);
+
+    EXPECT_EQ(after.writes, before.writes);
+    EXPECT_EQ(after.reads, before.reads);
+}
+
+TEST_F(GivenSimulatedSlave, WhenNoPeriodThenShouldConvertAllChannelsContinuously){
+    IOModSchedule_t schedule;
+
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.mode, kIOModScheduleMode_Continuous);
+    EXPECT_EQ(schedule.channelMask, 0xFF);
+    EXPECT_EQ(schedule.missedMask, 0);
+    EXPECT_EQ(schedule.periodUs, 8u * kADC128D818_VoltageConversionUs);
+    EXPECT_EQ(schedule.dutyCyclePpm, 1000000u);
+}
+
+TEST_F(GivenSimulatedSlave, WhenShortPeriodThenShouldOnlyConvertChannelsWithPeriod){
+    IOModSchedule_t schedule;
+    int32_t value;
+
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 1, 100000), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.mode, kIOModScheduleMode_Continuous);
+    EXPECT_EQ(schedule.channelMask, 1 << 1);
+    EXPECT_EQ(schedule.periodUs, (uint32_t)kADC128D818_VoltageConversionUs);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 0, &value), kIOModPortStatus_NotDetected);
+
+    uint32_t count = Scan(1000000, 10000);
+    EXPECT_GE(count, 1000000u / kADC128D818_VoltageConversionUs);
+    EXPECT_LE(count, 1000000u / kADC128D818_VoltageConversionUs + 1);
+}
+
+TEST_F(GivenSimulatedSlave, WhenPeriodAboveLowPowerCycleThenShouldUseLowPowerMode){
+    IOModSchedule_t schedule;
+    ADC128D818SimBusStats_t stats;
+
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 1, 1000000), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 2, 1000000), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.mode, kIOModScheduleMode_LowPower);
+    EXPECT_EQ(schedule.periodUs, (uint32_t)kADC128D818_LowPowerCycleUs);
+    EXPECT_EQ(schedule.dutyCyclePpm, 2ull * kADC128D818_VoltageConversionUs * 1000000 / kADC128D818_LowPowerCycleUs);
+
+    // 2 conversions per cycle.
+    uint32_t count = Scan(10 * kADC128D818_LowPowerCycleUs, 10000);
+    EXPECT_GE(count, 20u);
+    EXPECT_LE(count, 22u);
+
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.staleReadingReads, 0u);
+    EXPECT_LE(stats.readingReads, 22u);
+}
+
+TEST_F(GivenSimulatedSlave, WhenLongPeriodThenShouldConvertOneShot){
+    IOModSchedule_t schedule;
+    ADC128D818SimBusStats_t stats;
+    IOModSample_t sample;
+
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 3, 5000000), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.mode, kIOModScheduleMode_OneShot);
+    EXPECT_EQ(schedule.periodUs, 5000000u);
+    EXPECT_EQ(schedule.dutyCyclePpm, (uint32_t)kADC128D818_VoltageConversionUs / 5);
+
+    ADC128D818SimSetInput(device, 3, 1234);
+    uint32_t count = Scan(20000000, 10000);
+    EXPECT_GE(count, 4u);
+    EXPECT_LE(count, 5u);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveID, 3, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 1234);
+
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.staleReadingReads, 0u);
+    EXPECT_EQ(stats.readingReads, count);
+
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.periodUs, 5000000u);
+    EXPECT_EQ(schedule.missedMask, 0);
+}
+
+TEST_F(GivenSimulatedSlave, WhenScanSlowerThanOneShotPeriodThenShouldReportAchievedPeriod){
+    IOModSchedule_t schedule;
+
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 3, 2000000), kIOModPortStatus_Valid);
+
+    // Conversions are started and read on scan visits, one every 2 visits.
+    EXPECT_EQ(Scan(20000000, 2500000), 4u);
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.mode, kIOModScheduleMode_OneShot);
+    // Plus the bus time of the visits.
+    EXPECT_GE(schedule.periodUs, 5000000u);
+    EXPECT_LT(schedule.periodUs, 5001000u);
+    EXPECT_EQ(schedule.missedMask, 1 << 3);
+}
+
+TEST_F(GivenSimulatedSlave, WhenPeriodNotReachableThenShouldReportMissedChannels){
+    IOModSchedule_t schedule;
+
+    for (uint8_t channelIdx = 0; channelIdx < kIOModChannelsPerSlave; channelIdx ++)
+    {
+        EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, channelIdx, 50000), kIOModPortStatus_Valid);
+    }
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.missedMask, 0xFF);
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 0x01), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.channelMask, 0x01);
+    EXPECT_EQ(schedule.missedMask, 0xFE);
+}
+
+TEST_F(GivenSimulatedSlave, WhenNoChannelConvertedThenShouldShutdown){
+    IOModSchedule_t schedule;
+
+    EXPECT_EQ(IOModSetChannelMask(kSlaveID, 0), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetSchedule(kSlaveID, &schedule), kIOModPortStatus_Valid);
+    EXPECT_EQ(schedule.mode, kIOModScheduleMode_Shutdown);
+    EXPECT_EQ(schedule.dutyCyclePpm, 0u);
+    EXPECT_EQ(Scan(1000000, 10000), 0u);
+}
+
+TEST_F(GivenSimulatedSlave, WhenNoNewConversionThenReadIfNewShouldNotReadTheBus){
+    ADC128D818SimBusStats_t stats;
+    IOModSample_t sample;
+
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_Valid);
+
+    // Scanned sample.
+    ADC128D818SimGetBusStats(0, &stats);
+    uint32_t reads = stats.reads;
+    uint32_t scanUs = NowUs();
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Valid);
+    EXPECT_LE(sample.timestampUs, scanUs);
+
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Pending);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID) / 2);
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Pending);
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.reads, reads);
+}
+
+TEST_F(GivenSimulatedSlave, WhenFirstReadOfStaleScannedChannelThenReadIfNewShouldNotReturnItAsNew){
+    ADC128D818SimBusStats_t stats;
+    IOModSample_t sample;
+
+    // Channel not read with IOModReadIfNew yet, scanned long ago.
+    ScanInput(2, 1111);
+    ADC128D818SimSetInput(device, 2, 3333);
+    ADC128D818SimAdvance(10 * IOModGetConversionCycleUs(kSlaveID));
+    ADC128D818SimGetBusStats(0, &stats);
+    uint32_t reads = stats.reads;
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 2, NowUs(), &sample), kIOModPortStatus_Pending);
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.reads, reads);
+
+    // Then read as any channel without a newer scanned sample.
+    uint32_t readUs = NowUs();
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 2, readUs, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 3333);
+    EXPECT_EQ(sample.timestampUs, readUs);
+}
+
+TEST_F(GivenSimulatedSlave, WhenNewConversionThenReadIfNewShouldReadTheChannelOnce){
+    ADC128D818SimBusStats_t stats;
+    IOModSample_t sample;
+
+    // Previous reads and scanned samples are consumed.
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Valid);
+
+    ADC128D818SimSetInput(device, 6, 2222);
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    ADC128D818SimGetBusStats(0, &stats);
+    uint32_t reads = stats.reads;
+    uint32_t readUs = NowUs();
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, readUs, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 2222);
+    EXPECT_EQ(sample.timestampUs, readUs);
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.reads, reads + 1);
+
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Pending);
+    ADC128D818SimGetBusStats(0, &stats);
+    EXPECT_EQ(stats.reads, reads + 1);
+}
+
+// Bus 0 port failing the reads of one register of the simulated slave.
+class GivenFailingRegister : public GivenSimulatedSlave{
+    protected:
+        GivenFailingRegister(){
+            IOModBusPort_t port = {};
+
+            gFailRegister = kNoRegister;
+            port.readRegister = ReadRegister;
+            port.writeRegister = WriteRegister;
+            IOModBusInit(0, &port);
+        }
+
+        ~GivenFailingRegister(){
+            IOModBusPort_t port = {};
+
+            IOModBusInit(0, &port);
+        }
+
+        static int ReadRegister(uint8_t inAddress, uint8_t inRegister, uint8_t* outData, uint16_t inSize){
+            if (inRegister == gFailRegister)
+            {
+                return -1;
+            }
+            return ADC128D818SimReadRegister(mIOModBusDevice(0, inAddress), inRegister, outData, inSize);
+        }
+
+        static int WriteRegister(uint8_t inAddress, uint8_t inRegister, uint8_t* inData, uint16_t inSize){
+            return ADC128D818SimWriteRegister(mIOModBusDevice(0, inAddress), inRegister, inData, inSize);
+        }
+
+        static const uint16_t kNoRegister = 0x100;
+        static uint16_t gFailRegister;
+};
+
+uint16_t GivenFailingRegister::gFailRegister;
+
+TEST_F(GivenFailingRegister, WhenChannelReadFailsThenReadIfNewShouldReportItAndRetry){
+    IOModSample_t sample;
+
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Valid);
+
+    gFailRegister = kADC128D818_RegisterChannel0Read + 6;
+    ADC128D818SimAdvance(IOModGetConversionCycleUs(kSlaveID));
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_DriverBusError);
+    // Not taken as read.
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_DriverBusError);
+
+    gFailRegister = kNoRegister;
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModReadIfNew(kSlaveID, 6, NowUs(), &sample), kIOModPortStatus_Pending);
+}
+
+TEST_F(GivenFailingRegister, WhenBusyStatusReadFailsThenOneShotScanShouldReportBusError){
+    IOModPortStatus_e scanStatus = kIOModPortStatus_Pending;
+    IOModSample_t sample;
+
+    EXPECT_EQ(IOModSetChannelPeriod(kSlaveID, 3, 5000000), kIOModPortStatus_Valid);
+    ADC128D818SimSetInput(device, 3, 1234);
+
+    // Conversion triggered, its end can not be read.
+    gFailRegister = kADC128D818_RegisterBusyStatus;
+    for (uint8_t scanIdx = 0; scanIdx < 10; scanIdx ++)
+    {
+        IOModScanProcess(NowUs());
+        ADC128D818SimAdvance(10000);
+    }
+    EXPECT_EQ(IOModScanProcess(NowUs()), kIOModPortStatus_DriverBusError);
+    EXPECT_EQ(IOModScanSubmit(NowUs(), OnScanDone, &scanStatus), kIOModPortStatus_DriverBusError);
+    EXPECT_TRUE(IOModBusIdle(0));
+
+    // Retried once the bus recovers.
+    gFailRegister = kNoRegister;
+    uint32_t scanUs = NowUs();
+    EXPECT_EQ(IOModScanSubmit(scanUs, OnScanDone, &scanStatus), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModBusProcess(0), 1);
+    EXPECT_EQ(scanStatus, kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetLatestSample(kSlaveID, 3, &sample), kIOModPortStatus_Valid);
+    EXPECT_EQ(sample.rawData, 1234);
+    EXPECT_EQ(sample.timestampUs, scanUs);
+}
+
+TEST_F(GivenSimulatedSlave, WhenInputAtRawLimitThenCurrentShouldBeValidAndOverLoadAbove){
+    int32_t value;
+
+    EXPECT_EQ(IOModSetCurrentLimit(kSlaveID, 1, 150), kIOModPortStatus_Valid);
+
+    // 2054 * 4801 / 2^16 = 150.47, rounded down to the limit.
+    ScanInput(1, 2054);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 1, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 1), kIOModPortStatus_Valid);
+
+    // 2055 * 4801 / 2^16 = 150.55, rounded up past the limit.
+    ScanInput(1, 2055);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 1, &value), kIOModPortStatus_OverLoad);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 1), kIOModPortStatus_OverLoad);
+
+    EXPECT_EQ(IOModSetCurrentLimit(kSlaveID, 1, kIOModCurrentLimitDefault), kIOModPortStatus_Valid);
+}
+
+TEST_F(GivenSimulatedSlave, WhenLimitSetThenRawThresholdShouldBeTheLastCodeDecodedWithinIt){
+    const int32_t kLimits[] = { 0, 1, 100, 150, 299 };
+    int32_t value;
+
+    for (int32_t limit : kLimits)
+    {
+        uint16_t limitRaw;
+        EXPECT_EQ(ConversionEncode((uint16_t)limit, 4801, 16, 1, &limitRaw), 0);
+        EXPECT_LE(ConversionDecode(limitRaw, 4801, 16, 1), limit);
+        EXPECT_GT(ConversionDecode(limitRaw + 1, 4801, 16, 1), limit);
+        EXPECT_EQ(IOModSetCurrentLimit(kSlaveID, 1, limit), kIOModPortStatus_Valid);
+
+        ScanInput(1, limitRaw);
+        EXPECT_EQ(IOModCheckCurrent(kSlaveID, 1), kIOModPortStatus_Valid) << "Limit " << limit;
+        EXPECT_EQ(IOModGetCurrent(kSlaveID, 1, &value), kIOModPortStatus_Valid) << "Limit " << limit;
+        EXPECT_EQ(value, ConversionDecode(limitRaw, 4801, 16, 1));
+
+        ScanInput(1, limitRaw + 1);
+        EXPECT_EQ(IOModCheckCurrent(kSlaveID, 1), kIOModPortStatus_OverLoad) << "Limit " << limit;
+        EXPECT_EQ(IOModGetCurrent(kSlaveID, 1, &value), kIOModPortStatus_OverLoad) << "Limit " << limit;
+    }
+
+    EXPECT_EQ(IOModSetCurrentLimit(kSlaveID, 1, kIOModCurrentLimitDefault), kIOModPortStatus_Valid);
+}
+
+// (x * 4801 / 2^16) * (1 + 3277 / 2^15) + 10 mA.
+static const ConversionCalibration_t kCalibration = { { 4801, 16, 1 }, 10, 3277 };
+
+TEST_F(GivenSimulatedSlave, WhenChannelCalibratedThenCurrentAndLimitShouldUseTheFusedCalibration){
+    ConversionFused_t fused;
+    uint16_t limitRaw;
+    int32_t value;
+
+    EXPECT_EQ(ConversionFuse(&kCalibration, &fused), 0);
+    EXPECT_EQ(ConversionEncodeFused(200, &fused, &limitRaw), 0);
+    EXPECT_EQ(IOModSetCurrentLimit(kSlaveID, 2, 200), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModSetChannelCalibration(kSlaveID, 2, &kCalibration), kIOModPortStatus_Valid);
+
+    // 150.03 * 1.1 + 10.
+    ScanInput(2, 1900);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, ConversionDecodeFused(1900, &fused));
+    EXPECT_EQ(value, 163);
+
+    // Threshold converted through the calibration.
+    ScanInput(2, limitRaw);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 2), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_LE(value, 200);
+    ScanInput(2, limitRaw + 1);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 2), kIOModPortStatus_OverLoad);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_OverLoad);
+
+    // Default conversion restored.
+    ConversionCalibration_t calibration = {};
+    EXPECT_EQ(IOModSetChannelCalibration(kSlaveID, 2, &calibration), kIOModPortStatus_Valid);
+    EXPECT_EQ(IOModSetCurrentLimit(kSlaveID, 2, kIOModCurrentLimitDefault), kIOModPortStatus_Valid);
+    ScanInput(2, 2048);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 2, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+}
+
+TEST_F(GivenSimulatedSlave, WhenCalibrationsLoadedThenChannelsShouldUseThem){
+    ConversionFused_t fused;
+    uint16_t limitRaw;
+    int32_t value;
+
+    memset(&gCalibrations, 0, sizeof(gCalibrations));
+    gCalibrations.channels[kSlaveID][4] = kCalibration;
+    EXPECT_EQ(IOModLoadCalibrations(kCalibrationsAddress), kIOModPortStatus_Valid);
+
+    ScanInput(4, 1900);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 4, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 163);
+    // Entries left to 0 keep the default conversion: 2048 * 4801 / 2^16.
+    ScanInput(3, 2048);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 3, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+
+    // Default limit through the calibration.
+    EXPECT_EQ(ConversionFuse(&kCalibration, &fused), 0);
+    EXPECT_EQ(ConversionEncodeFused(kIOModCurrentLimitDefault, &fused, &limitRaw), 0);
+    ScanInput(4, limitRaw);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 4), kIOModPortStatus_Valid);
+    ScanInput(4, limitRaw + 1);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 4), kIOModPortStatus_OverLoad);
+
+    // Outside the board config, the calibrations are kept.
+    EXPECT_EQ(IOModLoadCalibrations(kCalibrationsAddress + sizeof(gCalibrations)), kIOModPortStatus_DriverBusError);
+    EXPECT_EQ(IOModCheckCurrent(kSlaveID, 4), kIOModPortStatus_OverLoad);
+
+    // Default conversions restored.
+    memset(&gCalibrations, 0, sizeof(gCalibrations));
+    EXPECT_EQ(IOModLoadCalibrations(kCalibrationsAddress), kIOModPortStatus_Valid);
+    ScanInput(4, 2048);
+    EXPECT_EQ(IOModGetCurrent(kSlaveID, 4, &value), kIOModPortStatus_Valid);
+    EXPECT_EQ(value, 150);
+}
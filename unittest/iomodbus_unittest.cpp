@@ -0,0 +1,359 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "iomodbus.h"
+#include "adc128d818.h"
+#include "adc128d818sim.h"
+};
+
+static uint32_t gAssertCount;
+
+// Hooks of the library.
+extern "C" {
+void AssertFailure(const uint8_t* inFile, uint32_t inLine, const char* inFunction)
+{
+    (void)inFile;
+    (void)inLine;
+    (void)inFunction;
+
+    gAssertCount ++;
+}
+};
+
+static const uint16_t kDevice = mIOModBusDevice(0, kADC128D818_SlaveAddress1);
+static const uint16_t kAbsentDevice = mIOModBusDevice(0, kADC128D818_SlaveAddress2);
+static const uint16_t kUnknownBusDevice = mIOModBusDevice(kIOModBusMax, kADC128D818_SlaveAddress1);
+
+// Transactions in the order of their callbacks.
+static std::vector<IOModBusTransaction_t*> gDone;
+
+static void OnDone(IOModBusTransaction_t* inTransaction)
+{
+    gDone.push_back(inTransaction);
+}
+
+// Submit the transaction again until its context count reaches 0.
+static void OnDoneResubmit(IOModBusTransaction_t* inTransaction)
+{
+    uint32_t* count = (uint32_t*)inTransaction->context;
+
+    gDone.push_back(inTransaction);
+    if (*count > 0)
+    {
+        (*count) --;
+        IOModBusSubmit(inTransaction);
+    }
+}
+
+// Blocking read from the callback, its status in the context.
+static void OnDoneRead(IOModBusTransaction_t* inTransaction)
+{
+    uint8_t data;
+
+    gDone.push_back(inTransaction);
+    *(int*)inTransaction->context = IOModBusReadRegister(inTransaction->device, kADC128D818_RegisterManufacturerID, &data, 1);
+}
+
+static void SetRead(IOModBusTransaction_t* outTransaction, uint16_t inDevice, uint8_t* outData, IOModBusCallback_t inCallback = OnDone, void* inContext = NULL)
+{
+    *outTransaction = {};
+    outTransaction->operation = kIOModBusOperation_ReadRegister;
+    outTransaction->device = inDevice;
+    outTransaction->reg = kADC128D818_RegisterManufacturerID;
+    outTransaction->data = outData;
+    outTransaction->size = 1;
+    outTransaction->callback = inCallback;
+    outTransaction->context = inContext;
+}
+
+// Bus 0 on the simulator, transfers done by IOModBusProcess.
+class GivenPolledBus : public ::testing::Test{
+    protected:
+        GivenPolledBus(){
+            IOModBusPort_t port;
+
+            gAssertCount = 0;
+            gDone.clear();
+            ADC128D818SimReset();
+            ADC128D818SimAddDevice(kDevice);
+            ADC128D818SimGetPort(0, &port);
+            port.lock = this;
+            port.lockFunction = Lock;
+            port.unlockFunction = Unlock;
+            IOModBusInit(0, &port);
+        }
+
+        ~GivenPolledBus(){
+            EXPECT_EQ(lockDepth, 0);
+            EXPECT_EQ(gAssertCount, expectedAssertCount);
+        }
+
+        static void Lock(void* inLock){
+            GivenPolledBus* test = (GivenPolledBus*)inLock;
+            EXPECT_EQ(test->lockDepth, 0);
+            test->lockDepth ++;
+        }
+
+        static void Unlock(void* inLock){
+            ((GivenPolledBus*)inLock)->lockDepth --;
+        }
+
+        int lockDepth = 0;
+        uint32_t expectedAssertCount = 0;
+};
+
+// Interrupt driven port: start only records the transaction, the test completes it with IOModBusComplete.
+class GivenStartCompleteBus : public ::testing::Test{
+    protected:
+        GivenStartCompleteBus(){
+            IOModBusPort_t port = {};
+
+            gAssertCount = 0;
+            gDone.clear();
+            port.start = Start;
+            port.startContext = this;
+            IOModBusInit(0, &port);
+        }
+
+        ~GivenStartCompleteBus(){
+            EXPECT_EQ(gAssertCount, expectedAssertCount);
+        }
+
+        static int Start(IOModBusTransaction_t* inTransaction, void* inContext){
+            GivenStartCompleteBus* test = (GivenStartCompleteBus*)inContext;
+            test->started.push_back(inTransaction);
+            if (test->startFailures > 0)
+            {
+                test->startFailures --;
+                return -2;
+            }
+            // Transfer done before start returns.
+            if (test->completeOnStart)
+            {
+                IOModBusComplete(0, 0);
+            }
+            return 0;
+        }
+
+        std::vector<IOModBusTransaction_t*> started;
+        uint32_t startFailures = 0;
+        bool completeOnStart = false;
+        uint32_t expectedAssertCount = 0;
+};
+
+TEST_F(GivenPolledBus, WhenBatchSubmittedThenProcessShouldTransferItInOrder){
+    IOModBusTransaction_t transactions[3];
+    uint8_t data[3] = {};
+
+    SetRead(&transactions[0], kDevice, &data[0]);
+    SetRead(&transactions[1], kAbsentDevice, &data[1]);
+    SetRead(&transactions[2], kDevice, &data[2]);
+    IOModBusSubmitBatch(transactions, 3);
+
+    EXPECT_FALSE(IOModBusIdle(0));
+    EXPECT_FALSE(transactions[0].done);
+    EXPECT_TRUE(gDone.empty());
+
+    EXPECT_EQ(IOModBusProcess(0), 3);
+    EXPECT_TRUE(IOModBusIdle(0));
+    ASSERT_EQ(gDone.size(), 3u);
+    for (uint8_t transactionIdx = 0; transactionIdx < 3; transactionIdx ++)
+    {
+        EXPECT_EQ(gDone[transactionIdx], &transactions[transactionIdx]);
+        EXPECT_TRUE(transactions[transactionIdx].done);
+    }
+    EXPECT_EQ(transactions[0].status, 0);
+    EXPECT_NE(transactions[1].status, 0);
+    EXPECT_EQ(transactions[2].status, 0);
+    EXPECT_EQ(data[0], kADC128D818_ManufacturerID);
+    EXPECT_EQ(data[2], kADC128D818_ManufacturerID);
+    EXPECT_EQ(IOModBusProcess(0), 0);
+}
+
+TEST_F(GivenPolledBus, WhenCallbackResubmitsThenSameProcessShouldTransferItAgain){
+    IOModBusTransaction_t transaction;
+    uint8_t data = 0;
+    uint32_t count = 2;
+
+    SetRead(&transaction, kDevice, &data, OnDoneResubmit, &count);
+    IOModBusSubmit(&transaction);
+
+    EXPECT_EQ(IOModBusProcess(0), 3);
+    EXPECT_EQ(gDone.size(), 3u);
+    EXPECT_EQ(count, 0u);
+    EXPECT_TRUE(IOModBusIdle(0));
+}
+
+TEST_F(GivenPolledBus, WhenDeviceOnUnknownBusThenTransactionShouldFailAtSubmit){
+    IOModBusTransaction_t transactions[2];
+    uint8_t data[2] = {};
+
+    SetRead(&transactions[0], kUnknownBusDevice, &data[0]);
+    SetRead(&transactions[1], kDevice, &data[1]);
+    IOModBusSubmitBatch(transactions, 2);
+
+    ASSERT_EQ(gDone.size(), 1u);
+    EXPECT_EQ(gDone[0], &transactions[0]);
+    EXPECT_EQ(transactions[0].status, -1);
+    EXPECT_EQ(IOModBusProcess(0), 1);
+    EXPECT_EQ(transactions[1].status, 0);
+    EXPECT_EQ(IOModBusReadRegister(kUnknownBusDevice, kADC128D818_RegisterManufacturerID, data, 1), -1);
+}
+
+TEST_F(GivenPolledBus, WhenTransactionsQueuedThenBlockingAccessShouldRunAfterThem){
+    IOModBusTransaction_t transaction;
+    uint8_t data[2] = {};
+
+    EXPECT_EQ(IOModBusReadRegister(kDevice, kADC128D818_RegisterManufacturerID, &data[0], 1), 0);
+    EXPECT_EQ(data[0], kADC128D818_ManufacturerID);
+
+    data[0] = 0;
+    SetRead(&transaction, kDevice, &data[0]);
+    IOModBusSubmit(&transaction);
+    EXPECT_EQ(IOModBusReadRegister(kDevice, kADC128D818_RegisterManufacturerID, &data[1], 1), 0);
+    EXPECT_EQ(data[1], kADC128D818_ManufacturerID);
+
+    // Transferred first.
+    ASSERT_EQ(gDone.size(), 1u);
+    EXPECT_EQ(gDone[0], &transaction);
+    EXPECT_EQ(transaction.status, 0);
+    EXPECT_EQ(data[0], kADC128D818_ManufacturerID);
+    EXPECT_TRUE(IOModBusIdle(0));
+    EXPECT_EQ(IOModBusProcess(0), 0);
+}
+
+TEST_F(GivenPolledBus, WhenCallbackAccessesTheBusThenAccessShouldBeDone){
+    IOModBusTransaction_t transactions[2];
+    uint8_t data[3] = {};
+    int status = -1;
+
+    SetRead(&transactions[0], kDevice, &data[0], OnDoneRead, &status);
+    SetRead(&transactions[1], kDevice, &data[1]);
+    transactions[0].data = &data[2];
+    IOModBusSubmitBatch(transactions, 2);
+
+    // The blocking access of the callback transfers the queue up to its own transaction.
+    EXPECT_EQ(IOModBusProcess(0), 1);
+    EXPECT_EQ(status, 0);
+    EXPECT_TRUE(transactions[1].done);
+    EXPECT_TRUE(IOModBusIdle(0));
+}
+
+TEST_F(GivenStartCompleteBus, WhenBatchSubmittedThenTransfersShouldRunBackToBack){
+    IOModBusTransaction_t transactions[2];
+    uint8_t data[2] = {};
+
+    SetRead(&transactions[0], kDevice, &data[0]);
+    SetRead(&transactions[1], kDevice, &data[1]);
+    IOModBusSubmitBatch(transactions, 2);
+
+    // Only the first one is started, the port does the transfers.
+    ASSERT_EQ(started.size(), 1u);
+    EXPECT_EQ(started[0], &transactions[0]);
+    EXPECT_EQ(IOModBusProcess(0), 0);
+    EXPECT_FALSE(IOModBusIdle(0));
+
+    // The next one is started before the callback of the completed one.
+    IOModBusComplete(0, 0);
+    ASSERT_EQ(started.size(), 2u);
+    EXPECT_EQ(started[1], &transactions[1]);
+    ASSERT_EQ(gDone.size(), 1u);
+    EXPECT_TRUE(transactions[0].done);
+    EXPECT_EQ(transactions[0].status, 0);
+    EXPECT_FALSE(IOModBusIdle(0));
+
+    IOModBusComplete(0, -3);
+    ASSERT_EQ(gDone.size(), 2u);
+    EXPECT_EQ(transactions[1].status, -3);
+    EXPECT_TRUE(IOModBusIdle(0));
+
+    // Spurious completion.
+    IOModBusComplete(0, 0);
+    EXPECT_EQ(gDone.size(), 2u);
+}
+
+TEST_F(GivenStartCompleteBus, WhenCallbackResubmitsThenTransactionShouldBeStartedAgain){
+    IOModBusTransaction_t transaction;
+    uint8_t data = 0;
+    uint32_t count = 1;
+
+    SetRead(&transaction, kDevice, &data, OnDoneResubmit, &count);
+    IOModBusSubmit(&transaction);
+    ASSERT_EQ(started.size(), 1u);
+
+    IOModBusComplete(0, 0);
+    EXPECT_EQ(started.size(), 2u);
+    EXPECT_FALSE(transaction.done);
+    EXPECT_FALSE(IOModBusIdle(0));
+
+    IOModBusComplete(0, 0);
+    EXPECT_EQ(started.size(), 2u);
+    EXPECT_EQ(gDone.size(), 2u);
+    EXPECT_TRUE(transaction.done);
+    EXPECT_TRUE(IOModBusIdle(0));
+}
+
+TEST_F(GivenStartCompleteBus, WhenStartFailsThenTransactionShouldFailAndNextOneStart){
+    IOModBusTransaction_t transactions[2];
+    uint8_t data[2] = {};
+
+    startFailures = 1;
+    SetRead(&transactions[0], kDevice, &data[0]);
+    SetRead(&transactions[1], kDevice, &data[1]);
+    IOModBusSubmitBatch(transactions, 2);
+
+    ASSERT_EQ(started.size(), 2u);
+    ASSERT_EQ(gDone.size(), 1u);
+    EXPECT_EQ(gDone[0], &transactions[0]);
+    EXPECT_EQ(transactions[0].status, -2);
+    EXPECT_FALSE(transactions[1].done);
+
+    IOModBusComplete(0, 0);
+    EXPECT_EQ(transactions[1].status, 0);
+    EXPECT_TRUE(IOModBusIdle(0));
+}
+
+TEST_F(GivenStartCompleteBus, WhenUnknownBusCompletesThenShouldAssertAndIgnoreIt){
+    IOModBusTransaction_t transaction;
+    uint8_t data = 0;
+
+    SetRead(&transaction, kDevice, &data);
+    IOModBusSubmit(&transaction);
+
+    expectedAssertCount = 1;
+    IOModBusComplete(kIOModBusMax, 0);
+    EXPECT_EQ(gAssertCount, 1u);
+    EXPECT_FALSE(transaction.done);
+
+    IOModBusComplete(0, 0);
+    EXPECT_TRUE(transaction.done);
+}
+
+TEST_F(GivenStartCompleteBus, WhenBlockingAccessThenShouldWaitForItsCompletion){
+    uint8_t data = 0;
+
+    completeOnStart = true;
+    EXPECT_EQ(IOModBusReadRegister(kDevice, kADC128D818_RegisterManufacturerID, &data, 1), 0);
+    EXPECT_EQ(started.size(), 1u);
+    EXPECT_TRUE(IOModBusIdle(0));
+}
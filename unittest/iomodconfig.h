@@ -0,0 +1,46 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef IOMODCONFIG_H_
+#define IOMODCONFIG_H_
+
+// Test configuration for boardconfig.c, define kBoardConfigTest_Header to enable the fast boot header.
+#include "iomodutils.h"
+
+#define kBoardConfigStartAddress 0x100
+#ifdef kBoardConfigTest_Header
+#define kBoardConfigTotalSize 80
+#define kBoardConfig_HeaderAddressOffset 64
+#else
+#define kBoardConfigTotalSize 64
+#endif
+
+#define kBoardConfig_Factory_Magic 0
+#define kBoardConfig_Factory_FlashLayout 2
+#define kBoardConfig_Factory_CRC 4
+#define kBoardConfig_User_CRC 6
+#define kBoardConfig_FactoryAddressOffset 8
+#define kBoardConfig_FactorySize 24
+#define kBoardConfig_UserAddressOffset 32
+#define kBoardConfig_UserSize 32
+#define kBoardConfig_MagicNumber 0xBC01
+
+#define mBoardConfigPrintWarning(x)
+#define mBoardConfigPrintInfo(x)
+
+#endif // IOMODCONFIG_H_
@@ -0,0 +1,107 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+extern "C" {
+#include "iomodfilter.h"
+};
+
+static std::vector<uint32_t> RunFilter(IOModFilter_t* inFilter, const std::vector<uint16_t>& inSamples)
+{
+    std::vector<uint32_t> outputs;
+
+    for (auto sample : inSamples)
+    {
+        uint32_t value;
+        if (IOModFilterProcess(inFilter, sample, &value))
+        {
+            outputs.push_back(value);
+        }
+    }
+
+    return outputs;
+}
+
+TEST(GivenFilterConfig, WhenNotSupportedThenInitShouldFail){
+    IOModFilter_t filter;
+    IOModFilterConfig_t orderTooHigh = {1, kIOModFilterMaxCICOrder + 1, 0};
+    IOModFilterConfig_t gainTooHigh = {8, 3, 0};
+    IOModFilterConfig_t decimationTooHigh = {16, 1, 0};
+
+    EXPECT_EQ(IOModFilterInit(&filter, &orderTooHigh), -1);
+    EXPECT_EQ(IOModFilterInit(&filter, &gainTooHigh), -1);
+    EXPECT_EQ(IOModFilterInit(&filter, &decimationTooHigh), -1);
+}
+
+TEST(GivenBoxcarFilter, WhenSamplesProcessedThenShouldOutputAveragePerBlock){
+    IOModFilter_t filter;
+    IOModFilterConfig_t config = {2, 1, 0};
+
+    ASSERT_EQ(IOModFilterInit(&filter, &config), 0);
+    std::vector<uint32_t> outputs = RunFilter(&filter, {1, 2, 3, 4, 4095, 4095, 4095, 4094});
+
+    ASSERT_EQ(outputs.size(), 2u);
+    // 2.5 and 4094.75 in Q8.
+    EXPECT_EQ(outputs[0], 640u);
+    EXPECT_EQ(outputs[1], 1048256u);
+}
+
+class GivenCICFilter : public ::testing::TestWithParam<IOModFilterConfig_t>{
+};
+
+TEST_P(GivenCICFilter, WhenConstantInputThenShouldOutputInputInQ8){
+    IOModFilter_t filter;
+    IOModFilterConfig_t config = GetParam();
+
+    ASSERT_EQ(IOModFilterInit(&filter, &config), 0);
+    std::vector<uint32_t> outputs = RunFilter(&filter, std::vector<uint16_t>(4096, 4095));
+
+    // Decimation ratio and transient drop of order - 1 outputs.
+    uint8_t cicOrder = config.cicOrder ? config.cicOrder : 1;
+    ASSERT_EQ(outputs.size(), (4096u >> config.decimationShift) - (cicOrder - 1));
+    for (auto output : outputs)
+    {
+        EXPECT_EQ(output, 4095u << kIOModFilterFractionBits);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(IOModFilter, GivenCICFilter, ::testing::Values(
+        IOModFilterConfig_t{0, 0, 0},
+        IOModFilterConfig_t{3, 1, 0},
+        IOModFilterConfig_t{4, 2, 0},
+        IOModFilterConfig_t{6, 3, 0},
+        IOModFilterConfig_t{4, 2, 4}
+        ));
+
+TEST(GivenIIRFilter, WhenStepInputThenShouldConvergeToStep){
+    IOModFilter_t filter;
+    IOModFilterConfig_t config = {0, 1, 3};
+    std::vector<uint16_t> samples(1, 0);
+
+    samples.resize(200, 1000);
+    ASSERT_EQ(IOModFilterInit(&filter, &config), 0);
+    std::vector<uint32_t> outputs = RunFilter(&filter, samples);
+
+    EXPECT_EQ(outputs.front(), 0u);
+    // Smoothed, 1/8 of the step on the first sample.
+    EXPECT_EQ(outputs[1], (1000u << kIOModFilterFractionBits) / 8);
+    EXPECT_NEAR(outputs.back(), 1000u << kIOModFilterFractionBits, 8);
+}
@@ -0,0 +1,110 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "iomodstats.h"
+};
+
+class GivenStatsAccumulator : public ::testing::Test{
+    protected:
+        GivenStatsAccumulator(){
+            IOModStatsReset(&accumulator);
+        }
+
+        IOModStatsAccumulator_t accumulator;
+        IOModStats_t stats;
+};
+
+TEST_F(GivenStatsAccumulator, WhenNoSampleThenShouldReturnZeroCount){
+    IOModStatsSnapshot(&accumulator, &stats);
+    EXPECT_EQ(stats.count, 0u);
+    EXPECT_EQ(stats.mean, 0);
+    EXPECT_EQ(stats.rms, 0);
+}
+
+TEST_F(GivenStatsAccumulator, WhenOneSampleThenShouldReturnIt){
+    IOModStatsUpdate(&accumulator, -1234);
+    IOModStatsSnapshot(&accumulator, &stats);
+
+    EXPECT_EQ(stats.count, 1u);
+    EXPECT_EQ(stats.mean, -1234);
+    EXPECT_EQ(stats.variance, 0u);
+    EXPECT_EQ(stats.ema, -1234);
+    EXPECT_EQ(stats.rms, 1234);
+    EXPECT_EQ(stats.min, -1234);
+    EXPECT_EQ(stats.max, -1234);
+}
+
+TEST_F(GivenStatsAccumulator, WhenConstantSamplesThenEMAShouldConverge){
+    IOModStatsUpdate(&accumulator, 0);
+    for (int sampleIdx = 0; sampleIdx < 200; sampleIdx ++)
+    {
+        IOModStatsUpdate(&accumulator, 300);
+    }
+    IOModStatsSnapshot(&accumulator, &stats);
+
+    EXPECT_NEAR(stats.ema, 300, 1);
+    EXPECT_EQ(stats.min, 0);
+    EXPECT_EQ(stats.max, 300);
+}
+
+TEST_F(GivenStatsAccumulator, WhenManySamplesThenShouldMatchDoubleComputation){
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int32_t> distribution(-40000, 150000);
+    std::vector<int32_t> values(100000);
+    double sum = 0;
+    double sumSquares = 0;
+
+    for (auto& value : values)
+    {
+        value = distribution(generator);
+        sum += value;
+        sumSquares += (double)value * value;
+        IOModStatsUpdate(&accumulator, value);
+    }
+
+    double mean = sum / values.size();
+    double variance = 0;
+    for (auto value : values)
+    {
+        variance += (value - mean) * (value - mean);
+    }
+    variance /= values.size() - 1;
+
+    IOModStatsSnapshot(&accumulator, &stats);
+    EXPECT_EQ(stats.count, values.size());
+    EXPECT_NEAR(stats.mean, mean, 1);
+    EXPECT_NEAR((double)stats.variance, variance, variance * 1e-6);
+    EXPECT_NEAR(stats.rms, std::sqrt(sumSquares / values.size()), 1);
+}
+
+TEST_F(GivenStatsAccumulator, WhenResetThenShouldRestart){
+    IOModStatsUpdate(&accumulator, 10);
+    IOModStatsReset(&accumulator);
+    IOModStatsUpdate(&accumulator, 20);
+    IOModStatsSnapshot(&accumulator, &stats);
+
+    EXPECT_EQ(stats.count, 1u);
+    EXPECT_EQ(stats.min, 20);
+}
@@ -0,0 +1,46 @@
+/* Copyright (C) 2017, Marc-Andre Guimond <guimond.marcandre@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is encoded in UTF-8.
+ */
+
+#ifndef UTILS_H_
+#define UTILS_H_
+
+// Test replacement for the project utils.h, only what the tested sources use.
+#include <stdint.h>
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Provided by the test (iomod_unittest advances the simulated time).
+void DelayUs(uint32_t inUs);
+/// Provided by the test (iomod_unittest returns the simulated time).
+uint32_t GetTimeUs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTILS_H_